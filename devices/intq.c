@@ -9,7 +9,7 @@ static void signal (struct intq *q, struct thread **waiter);
 /* Initializes interrupt queue Q. */
 void
 intq_init (struct intq *q) {
-	lock_init (&q->lock);
+	lock_init_named (&q->lock, "intq");
 	q->not_full = q->not_empty = NULL;
 	q->head = q->tail = 0;
 }
@@ -1,4 +1,5 @@
 #include "devices/timer.h"
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
@@ -17,9 +18,41 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
-/* Number of timer ticks since OS booted. */
+/* 8254 input frequency, in Hz. */
+#define PIT_FREQ 1193180
+
+/* 8254 input clocks per timer tick, rounded to nearest. */
+#define PIT_COUNTS_PER_TICK ((PIT_FREQ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest one-shot interval, in timer ticks, limited by the
+   16-bit counter (5 ticks, about 50 ms, at 100 Hz). */
+#define MAX_SHOT_TICKS (0xffff / PIT_COUNTS_PER_TICK)
+
+/* Number of timer ticks since OS booted.
+   In tickless mode, this is the number of ticks that
+   timer_interrupt() has processed so far, which may lag behind
+   timer_ticks() by the ticks of the one-shot in flight. */
 static int64_t ticks;
 
+/* Run the PIT in one-shot mode instead of periodic mode?
+   Set by the kernel command-line option -tickless. */
+bool timer_tickless;
+
+/* Tickless mode state.  PIT_COUNTS is the number of 8254 input
+   clocks that elapsed before the current one-shot was armed, and
+   SHOT_COUNTS is the length of that one-shot, or 0 if none is
+   armed. */
+static bool tickless_active;
+static uint64_t pit_counts;
+static uint16_t shot_counts;
+
+/* Number of timer interrupts taken. */
+static int64_t interrupts;
+
+/* Longest timer_interrupt() run, in TSC cycles, since boot or
+   the last timer_reset_interrupt_stats(). */
+static uint64_t max_interrupt_cycles;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -28,6 +61,8 @@ static intr_handler_func timer_interrupt;
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
+static uint32_t elapsed_in_shot(void);
+static void arm_shot(int64_t deadline);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -35,7 +70,7 @@ static void real_time_sleep(int64_t num, int32_t denom);
 void timer_init(void) {
     /* 8254 input frequency divided by TIMER_FREQ, rounded to
        nearest. */
-    uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+    uint16_t count = PIT_COUNTS_PER_TICK;
 
     outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
     outb(0x40, count & 0xff);
@@ -68,10 +103,47 @@ void timer_calibrate(void) {
     printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
 }
 
+/* Switches the PIT from periodic mode to one-shot mode.  From
+   now on a timer interrupt is only requested for the earliest
+   sleeper's wake_tick or the end of the running thread's time
+   slice, whichever comes first, so an idle system stops taking
+   an interrupt every tick.  Must be called after
+   timer_calibrate(), which counts interrupts to measure a tick. */
+void timer_start_tickless(void) {
+    enum intr_level old_level = intr_disable();
+
+    ASSERT(!tickless_active);
+    tickless_active = true;
+    pit_counts = (uint64_t)ticks * PIT_COUNTS_PER_TICK;
+    arm_shot(ticks + 1);
+    intr_set_level(old_level);
+}
+
+/* Makes sure a timer interrupt arrives no later than timer tick
+   DEADLINE, by cutting the one-shot in flight short if needed.
+   The ticks that already elapsed are not lost: the next
+   timer_interrupt() processes them.  Does nothing in periodic
+   mode, where an interrupt arrives every tick anyway. */
+void timer_arm(int64_t deadline) {
+    enum intr_level old_level;
+
+    if (!tickless_active)
+        return;
+
+    old_level = intr_disable();
+    if ((uint64_t)deadline * PIT_COUNTS_PER_TICK < pit_counts + shot_counts) {
+        pit_counts += elapsed_in_shot();
+        arm_shot(deadline);
+    }
+    intr_set_level(old_level);
+}
+
 /* Returns the number of timer ticks since the OS booted. */
 int64_t timer_ticks(void) {
     enum intr_level old_level = intr_disable();
     int64_t t = ticks;
+    if (tickless_active)
+        t = (pit_counts + elapsed_in_shot()) / PIT_COUNTS_PER_TICK;
     intr_set_level(old_level);
     barrier();
     return t;
@@ -86,8 +158,9 @@ void timer_sleep(int64_t ticks) {
     int64_t start = timer_ticks();
 
     ASSERT(intr_get_level() == INTR_ON);
-    while (timer_elapsed(start) < ticks)
-        thread_yield();
+    if (ticks <= 0)
+        return;
+    thread_sleep(start + ticks);
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -100,13 +173,112 @@ void timer_usleep(int64_t us) { real_time_sleep(us, 1000 * 1000); }
 void timer_nsleep(int64_t ns) { real_time_sleep(ns, 1000 * 1000 * 1000); }
 
 /* Prints timer statistics. */
-void timer_print_stats(void) { printf("Timer: %" PRId64 " ticks\n", timer_ticks()); }
+void timer_print_stats(void) {
+    if (tickless_active)
+        printf("Timer: %" PRId64 " ticks, %" PRId64 " interrupts (tickless)\n", timer_ticks(), interrupts);
+    else
+        printf("Timer: %" PRId64 " ticks\n", timer_ticks());
+}
+
+/* Returns the longest time, in TSC cycles, that the timer
+   interrupt handler has taken since boot or the last call to
+   timer_reset_interrupt_stats(). */
+uint64_t timer_max_interrupt_cycles(void) { return max_interrupt_cycles; }
+
+/* Starts a new measurement window for
+   timer_max_interrupt_cycles(). */
+void timer_reset_interrupt_stats(void) {
+    enum intr_level old_level = intr_disable();
+    max_interrupt_cycles = 0;
+    intr_set_level(old_level);
+}
 
 /* Timer interrupt handler. */
 static void timer_interrupt(struct intr_frame *args UNUSED) {
-    ticks++;
-    thread_tick();
-    thread_wake(ticks);
+    uint64_t start = rdtsc();
+    uint64_t cycles;
+
+    interrupts++;
+    if (!tickless_active) {
+        ticks++;
+        thread_tick(ticks);
+    } else {
+        /* A one-shot may span several ticks.  Run thread_tick()
+           once for each of them, passing the tick being processed,
+           so that time slices and the scheduler's per-tick
+           bookkeeping see every tick; timer_ticks() already
+           returns the last one throughout the loop.  Reading the
+           counter instead of trusting SHOT_COUNTS also accounts
+           for the interrupt latency and for a stale interrupt
+           from a one-shot that timer_arm() replaced. */
+        int64_t now;
+
+        pit_counts += elapsed_in_shot();
+        shot_counts = 0;
+        now = pit_counts / PIT_COUNTS_PER_TICK;
+        while (ticks < now) {
+            ticks++;
+            thread_tick(ticks);
+        }
+    }
+
+    /* Peek at the earliest sleeper before walking the sleep heap. */
+    if (thread_next_wake_tick() <= ticks)
+        thread_wake(ticks);
+
+    if (tickless_active) {
+        int64_t deadline = thread_next_wake_tick();
+        int64_t slice_left = thread_ticks_left();
+
+        if (slice_left != INT64_MAX && ticks + slice_left < deadline)
+            deadline = ticks + slice_left;
+        arm_shot(deadline);
+    }
+
+    cycles = rdtsc() - start;
+    if (cycles > max_interrupt_cycles)
+        max_interrupt_cycles = cycles;
+}
+
+/* Returns the number of 8254 input clocks that have elapsed
+   since the current one-shot was armed.  Interrupts must be
+   off. */
+static uint32_t elapsed_in_shot(void) {
+    uint16_t count;
+
+    if (shot_counts == 0)
+        return 0;
+
+    outb(0x43, 0x00); /* CW: counter 0, latch count. */
+    count = inb(0x40);
+    count |= inb(0x40) << 8;
+
+    /* Once the counter passes zero it wraps around to 0xffff and
+       keeps counting down, so a count above the programmed one
+       means the one-shot fired that many clocks ago. */
+    if (count <= shot_counts)
+        return shot_counts - count;
+    return shot_counts + (0x10000 - count);
+}
+
+/* Arms a one-shot that fires at timer tick DEADLINE, or after
+   MAX_SHOT_TICKS ticks if that is sooner.  PIT_COUNTS must
+   already include the clocks elapsed so far.  Interrupts must be
+   off. */
+static void arm_shot(int64_t deadline) {
+    uint64_t now = pit_counts;
+    uint64_t limit = now + MAX_SHOT_TICKS * PIT_COUNTS_PER_TICK;
+    uint64_t target = deadline < 0 ? 0 : (uint64_t)deadline * PIT_COUNTS_PER_TICK;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (deadline == INT64_MAX || target > limit)
+        target = limit;
+    shot_counts = target > now ? target - now : 1;
+
+    outb(0x43, 0x30); /* CW: counter 0, LSB then MSB, mode 0, binary. */
+    outb(0x40, shot_counts & 0xff);
+    outb(0x40, shot_counts >> 8);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -6,6 +6,8 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -33,6 +35,7 @@ struct inode {
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock rwlock;               /* Shared for reads, exclusive for writes. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -50,13 +53,42 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 }
 
 /* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
+ * returns the same `struct inode'.  Most opens find the inode
+ * already open, so the list is searched with OPEN_INODES_LOCK
+ * held shared and only changed with it held exclusive. */
 static struct list open_inodes;
+static struct rwlock open_inodes_lock;
+
+/* In-memory inodes come from their own object cache.  An inode's
+ * RWLOCK is initialized once, when its slab is created, and is
+ * unlocked again whenever the inode is freed. */
+static struct kmem_cache *inode_cache;
+
+/* Guards open_cnt, which readers of open_inodes may bump
+ * concurrently. */
+static struct lock open_cnt_lock;
+
+static struct inode *find_open_inode (disk_sector_t sector);
+static void inode_ctor (void *);
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	rwlock_init (&open_inodes_lock);
+	lock_init_named (&open_cnt_lock, "inode open_cnt");
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode),
+			inode_ctor);
+	if (inode_cache == NULL)
+		PANIC ("inode cache creation failed");
+}
+
+/* Constructs the in-memory inode INODE_ for INODE_CACHE. */
+static void
+inode_ctor (void *inode_) {
+	struct inode *inode = inode_;
+
+	rwlock_init (&inode->rwlock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,39 +133,65 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode *inode, *other;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	rwlock_acquire_read (&open_inodes_lock);
+	inode = inode_reopen (find_open_inode (sector));
+	rwlock_release_read (&open_inodes_lock);
+	if (inode != NULL)
+		return inode;
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = kmem_cache_alloc (inode_cache);
 	if (inode == NULL)
 		return NULL;
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize.  The rwlock is already initialized. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
 	disk_read (filesys_disk, inode->sector, &inode->data);
+
+	/* Someone else may have opened the inode while we were
+	   reading it, in which case theirs wins. */
+	rwlock_acquire_write (&open_inodes_lock);
+	other = inode_reopen (find_open_inode (sector));
+	if (other == NULL)
+		list_push_front (&open_inodes, &inode->elem);
+	rwlock_release_write (&open_inodes_lock);
+
+	if (other != NULL) {
+		kmem_cache_free (inode_cache, inode);
+		return other;
+	}
 	return inode;
 }
 
+/* Returns the open inode for SECTOR, or a null pointer if there
+ * is none.  OPEN_INODES_LOCK must be held. */
+static struct inode *
+find_open_inode (disk_sector_t sector) {
+	struct list_elem *e;
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector)
+			return inode;
+	}
+	return NULL;
+}
+
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_cnt_lock);
 		inode->open_cnt++;
+		lock_release (&open_cnt_lock);
+	}
 	return inode;
 }
 
@@ -148,15 +206,24 @@ inode_get_inumber (const struct inode *inode) {
  * If INODE was also a removed inode, frees its blocks. */
 void
 inode_close (struct inode *inode) {
+	bool last;
+
 	/* Ignore null pointer. */
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
+	/* Drop our reference, and take the inode off the list if this
+	   was the last opener so that nobody can find it again. */
+	rwlock_acquire_write (&open_inodes_lock);
+	lock_acquire (&open_cnt_lock);
+	last = --inode->open_cnt == 0;
+	lock_release (&open_cnt_lock);
+	if (last)
 		list_remove (&inode->elem);
+	rwlock_release_write (&open_inodes_lock);
 
+	/* Release resources if this was the last opener. */
+	if (last) {
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
 			free_map_release (inode->sector, 1);
@@ -164,7 +231,7 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
+		kmem_cache_free (inode_cache, inode);
 	}
 }
 
@@ -185,6 +252,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+	rwlock_acquire_read (&inode->rwlock);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -220,6 +288,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
+	rwlock_release_read (&inode->rwlock);
 	free (bounce);
 
 	return bytes_read;
@@ -237,8 +306,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
+	rwlock_acquire_write (&inode->rwlock);
+	if (inode->deny_write_cnt) {
+		rwlock_release_write (&inode->rwlock);
 		return 0;
+	}
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -282,6 +354,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	rwlock_release_write (&inode->rwlock);
 	free (bounce);
 
 	return bytes_written;
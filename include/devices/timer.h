@@ -2,6 +2,7 @@
 #define DEVICES_TIMER_H
 
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -9,6 +10,10 @@
 
 void timer_init (void);
 void timer_calibrate (void);
+void timer_start_tickless (void);
+void timer_arm (int64_t deadline);
+
+extern bool timer_tickless;
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
@@ -19,5 +24,7 @@ void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
+uint64_t timer_max_interrupt_cycles (void);
+void timer_reset_interrupt_stats (void);
 
 #endif /* devices/timer.h */
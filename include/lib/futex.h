@@ -0,0 +1,9 @@
+#ifndef __LIB_FUTEX_H
+#define __LIB_FUTEX_H
+
+/* Return values of the futex_wait() system call. */
+#define FUTEX_WOKEN 0           /* Woken by futex_wake(). */
+#define FUTEX_AGAIN 1           /* *ADDR did not hold EXPECTED. */
+#define FUTEX_TIMEDOUT 2        /* TIMEOUT ticks passed without a wakeup. */
+
+#endif /* lib/futex.h */
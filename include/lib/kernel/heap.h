@@ -0,0 +1,73 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Binary heap.
+ *
+ * This is a binary min-heap that, like the list and hash table
+ * implementations, does not require dynamically allocated
+ * memory.  Each structure that can potentially be in a heap
+ * must embed a struct heap_elem member, and the heap_entry
+ * macro converts a struct heap_elem back to the structure that
+ * contains it.  Refer to lib/kernel/list.h for a detailed
+ * explanation of the technique.
+ *
+ * Instead of an array, the heap is kept as a complete binary
+ * tree linked through the embedded elements.  Element number N
+ * (counting from 1 in level order) is found by walking from the
+ * root along the bits of N below its most significant bit, so
+ * insertion, removal of the minimum, removal of an arbitrary
+ * element and re-keying an element are all O(log n), and
+ * peeking at the minimum is O(1).
+ *
+ * The heap orders elements with a heap_less_func supplied at
+ * initialization time.  A max-heap is obtained by supplying a
+ * function that returns true when A is greater than B.  If the
+ * key of an element that is in a heap changes, call
+ * heap_update() to restore the heap property. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *parent;   /* Parent, or null for the root. */
+	struct heap_elem *left;     /* Left child. */
+	struct heap_elem *right;    /* Right child. */
+};
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A should be nearer the
+   top of the heap than B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Minimum element, or null. */
+	size_t size;                /* Number of elements. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->parent   \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+size_t heap_size (struct heap *);
+bool heap_empty (struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,16 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+#include <stdint.h>
+
+/* Resource usage of a thread, as returned by the getrusage()
+   system call.  Times are in CPU timestamp counter cycles. */
+struct rusage {
+	uint64_t cpu_cycles;            /* Time spent running. */
+	uint64_t ready_cycles;          /* Time spent ready, waiting for the CPU. */
+	uint64_t blocked_cycles;        /* Time spent blocked. */
+	uint64_t voluntary_switches;    /* Switches away because it blocked. */
+	uint64_t involuntary_switches;  /* Switches away while still runnable. */
+};
+
+#endif /* lib/rusage.h */
@@ -36,6 +36,11 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra */
+	SYS_GETRUSAGE,              /* Obtain resource usage of this thread. */
+	SYS_FUTEX_WAIT,             /* Wait until woken if a word holds a value. */
+	SYS_FUTEX_WAKE,             /* Wake threads waiting on a word. */
 };
 
 #endif /* lib/syscall-nr.h */
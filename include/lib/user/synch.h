@@ -0,0 +1,46 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* User-space synchronization primitives built on the futex_wait()
+   and futex_wake() system calls.  Each one keeps its state in an
+   ordinary word of user memory and changes it with atomic
+   instructions, entering the kernel only to sleep when it has to
+   wait or to wake a thread that is known to be sleeping.  An
+   uncontended operation therefore never makes a system call. */
+
+/* Mutex. */
+struct mutex {
+	int state;                  /* 0: unlocked, 1: locked,
+	                               2: locked, maybe with waiters. */
+};
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* Condition variable. */
+struct condvar {
+	int seq;                    /* Bumped by every signal. */
+	int waiters;                /* Number of threads in condvar_wait(). */
+};
+
+void condvar_init (struct condvar *);
+void condvar_wait (struct condvar *, struct mutex *);
+void condvar_signal (struct condvar *);
+void condvar_broadcast (struct condvar *);
+
+/* Counting semaphore. */
+struct semaphore {
+	int value;                  /* Current value. */
+	int waiters;                /* Number of threads in sema_down(). */
+};
+
+void sema_init (struct semaphore *, int value);
+void sema_down (struct semaphore *);
+bool sema_try_down (struct semaphore *);
+void sema_up (struct semaphore *);
+
+#endif /* lib/user/synch.h */
@@ -4,6 +4,9 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <rusage.h>
+#include <futex.h>
+#include <stdint.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -37,6 +40,9 @@ unsigned tell (int fd);
 void close (int fd);
 
 int dup2(int oldfd, int newfd);
+int getrusage (struct rusage *usage);
+int futex_wait (int *addr, int expected, int64_t timeout);
+int futex_wake (int *addr, int n);
 
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
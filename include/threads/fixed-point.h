@@ -0,0 +1,36 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* MLFQS 계산을 위한 17.14 Fixed-point 연산 모음.
+ * 커널은 Floating-point를 사용할 수 없기 때문에 (-msoft-float, FPU 상태 저장 X),
+ * int의 하위 14비트를 소수부로 사용하는 방식으로 recent_cpu와 load_avg를 표현.
+ * x, y는 fixed-point 값, n은 일반 정수를 의미. */
+
+typedef int fixed_t;
+
+#define FP_SHIFT 14            // 소수부 비트 수
+#define FP_ONE (1 << FP_SHIFT) // fixed-point 1.0
+
+/* 정수 n을 fixed-point로 변환 */
+static inline fixed_t int_to_fp(int n) { return n * FP_ONE; }
+
+/* fixed-point x를 정수로 변환 (0 방향으로 버림) */
+static inline int fp_to_int(fixed_t x) { return x / FP_ONE; }
+
+/* fixed-point x를 정수로 변환 (가장 가까운 정수로 반올림) */
+static inline int fp_to_int_round(fixed_t x) { return x >= 0 ? (x + FP_ONE / 2) / FP_ONE : (x - FP_ONE / 2) / FP_ONE; }
+
+static inline fixed_t fp_add(fixed_t x, fixed_t y) { return x + y; }
+static inline fixed_t fp_sub(fixed_t x, fixed_t y) { return x - y; }
+static inline fixed_t fp_add_int(fixed_t x, int n) { return x + n * FP_ONE; }
+static inline fixed_t fp_sub_int(fixed_t x, int n) { return x - n * FP_ONE; }
+
+/* 곱셈/나눗셈은 중간값이 32비트를 넘을 수 있으니 64비트로 계산 */
+static inline fixed_t fp_mul(fixed_t x, fixed_t y) { return (fixed_t)(((int64_t)x) * y / FP_ONE); }
+static inline fixed_t fp_div(fixed_t x, fixed_t y) { return (fixed_t)(((int64_t)x) * FP_ONE / y); }
+static inline fixed_t fp_mul_int(fixed_t x, int n) { return x * n; }
+static inline fixed_t fp_div_int(fixed_t x, int n) { return x / n; }
+
+#endif /* threads/fixed-point.h */
@@ -2,12 +2,19 @@
 #define THREADS_MALLOC_H
 
 #include <debug.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/* -leaks: Record the call site of every allocation? */
+extern bool malloc_leak_check;
 
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+void malloc_drain (void);
+void malloc_print_stats (void);
 
 #endif /* threads/malloc.h */
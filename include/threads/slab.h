@@ -0,0 +1,23 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* 타입별 오브젝트 캐시 (Slab allocator).
+ * malloc()은 요청 크기를 2의 거듭제곱으로 올려서 할당하지만, 캐시는 오브젝트 크기 그대로 한 페이지 (slab)에 나란히 담음.
+ * 생성자 (ctor)를 지정하면 slab을 만들 때 오브젝트마다 한번만 호출되고, 이후 free된 오브젝트는 초기화된 상태를
+ * 유지한 채로 다음 kmem_cache_alloc()에 재사용됨 (따라서 free 전에 생성자 직후의 상태로 되돌려 놓아야 함). */
+
+struct kmem_cache;
+
+/* 오브젝트를 미리 초기화해두는 생성자 */
+typedef void kmem_ctor_func(void *obj);
+
+void kmem_init(void);
+struct kmem_cache *kmem_cache_create(const char *name, size_t size, kmem_ctor_func *ctor);
+void kmem_cache_destroy(struct kmem_cache *);
+void *kmem_cache_alloc(struct kmem_cache *);
+void kmem_cache_free(struct kmem_cache *, void *obj);
+void kmem_print_stats(void);
+
+#endif /* threads/slab.h */
@@ -0,0 +1,22 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+struct intr_frame;
+
+/* 커널 스레드 간 빠른 Context switch (threads/switch.S).
+ * 스레드는 항상 schedule() 안에서, 즉 커널 모드에서 CPU를 내주므로 intr_frame 전체 대신
+ * Callee-saved 레지스터 (rbx, rbp, r12-r15)만 자기 커널 스택에 push하고 그 rsp를 SAVE에 남긴다.
+ * 이렇게 멈춘 스레드는 rsp만 되돌린 뒤 pop과 ret으로 재개되며, iretq를 거치지 않는다. */
+
+/* 현재 스레드를 멈추고 (rsp를 SAVE에 저장) NEXT_RSP에 멈춰 있던 스레드를 재개 */
+void switch_fast(uint64_t *save, uint64_t next_rsp);
+
+/* 현재 스레드를 멈추고, 아직 한번도 실행되지 않은 스레드 등 TF로 시작해야 하는 스레드를 do_iret()으로 재개 */
+void switch_to_frame(uint64_t *save, struct intr_frame *tf);
+
+/* switch_fast()로 멈춘 스레드를 do_iret()으로 재개할 때 tf.rip로 쓰는 진입점 (rsp가 저장된 값이어야 함) */
+void switch_resume(void);
+
+#endif /* threads/switch.h */
@@ -1,42 +1,130 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* 우선순위 대기열 ; semaphore, condition variable, rwlock이 공유하는 대기 스레드들의 max-heap.
+ * 삽입/삭제 O(log n), 최고 우선순위 확인 O(1), 같은 우선순위끼리는 먼저 들어온 스레드가 먼저 나감 (FIFO).
+ * 기다리는 동안 Donation 등으로 우선순위가 바뀌면 thread_refresh_priority()가 waitqueue_update()로 위치를 갱신.
+ * owner (깨워줄 것으로 기대되는 스레드)를 지정하면 기다리는 스레드들이 owner에게 우선순위를 기부 (락의 holder와 같은 방식). */
+struct waitqueue {
+    struct heap waiters;        /* 기다리는 스레드들의 wait_elem. */
+    unsigned next_seq;          /* 다음에 들어올 스레드의 순번 (FIFO 목적). */
+    struct thread *owner;       /* 우선순위를 기부받는 스레드 (없으면 NULL). */
+    struct heap_elem owner_elem; /* owner의 owned_queues heap에 삽입되는 elem. */
+};
+
+void waitqueue_init(struct waitqueue *);
+void waitqueue_push(struct waitqueue *, struct thread *);
+struct thread *waitqueue_pop(struct waitqueue *);
+void waitqueue_update(struct thread *);
+bool waitqueue_empty(const struct waitqueue *);
+void waitqueue_set_owner(struct waitqueue *, struct thread *);
+int waitqueue_donated_priority(const struct waitqueue *);
+bool owned_queue_comparison(const struct heap_elem *, const struct heap_elem *, void *aux);
 
 /* A counting semaphore. */
 struct semaphore {
-    unsigned value;      /* Current value. */
-    struct list waiters; /* List of waiting threads. */
+    unsigned value;           /* Current value. */
+    struct waitqueue waiters; /* Waiting threads. */
 };
 
 void sema_init(struct semaphore *, unsigned value);
 void sema_down(struct semaphore *);
 bool sema_try_down(struct semaphore *);
 void sema_up(struct semaphore *);
+void sema_set_owner(struct semaphore *, struct thread *);
 void sema_self_test(void);
 
+/* 락 경합 통계 (-lockstat). lock_init_named()로 초기화된 락들은 초기화 위치마다 하나씩 공유하는 class에 누적됨.
+ * 스레드마다 있는 락 (fd_lock 등)처럼 수명이 짧은 락들도 class는 static이니 종료 시까지 남음. */
+struct lock_class {
+    const char *name;           /* 출력용 이름. */
+    struct lock_class *next;    /* 등록된 class들의 리스트 (lock_classes). */
+    long long acquires;         /* 확보 횟수. */
+    long long contended;        /* 그중 다른 스레드가 보유 중이라 기다린 횟수. */
+    long long donations;        /* 기다리면서 우선순위를 기부한 횟수. */
+    int donation_depth_max;     /* 한번의 기부로 우선순위가 바뀐 최대 소유자 수 (Chain 깊이). */
+    uint64_t wait_cycles;       /* 기다린 시간 합계 (TSC). */
+    uint64_t wait_max;          /* 가장 오래 기다린 시간. */
+    uint64_t hold_cycles;       /* 보유한 시간 합계. */
+    uint64_t hold_max;          /* 가장 오래 보유한 시간. */
+};
+
 /* Lock. */
 struct lock {
-    struct thread *holder;      /* Thread holding lock (for debugging). */
-    struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct thread *holder;        /* Thread holding lock (for debugging). */
+    struct semaphore semaphore;   /* Binary semaphore controlling access. */
+    struct heap donors;           /* Threads waiting for the lock, highest priority on top. */
+    struct heap_elem holder_elem; /* Element in the holder's held_locks heap. */
+    struct lock_class *class;     /* 경합 통계 (이름 없는 락이면 NULL). */
+    uint64_t acquired_at;         /* 확보한 시점의 TSC (-lockstat). */
 };
 
+/* 이름을 붙여 LOCK을 초기화 ; 이 호출 위치에서 초기화되는 모든 락이 하나의 lock_class를 공유 */
+#define lock_init_named(LOCK, NAME)                    \
+    do {                                               \
+        static struct lock_class lock_class_;          \
+        lock_init_class((LOCK), &lock_class_, (NAME)); \
+    } while (0)
+
+extern bool lock_profiling;
+
 void lock_init(struct lock *);
+void lock_init_class(struct lock *, struct lock_class *, const char *name);
+void lock_print_stats(void);
 void lock_acquire(struct lock *);
 bool lock_try_acquire(struct lock *);
 void lock_release(struct lock *);
 bool lock_held_by_current_thread(const struct lock *);
+int lock_donated_priority(const struct lock *);
+bool held_lock_comparison(const struct heap_elem *, const struct heap_elem *, void *aux);
+
+/* Reader-writer lock.
+ * 여러 스레드가 동시에 공유 (읽기) 모드로 보유하거나, 한 스레드가 배타 (쓰기) 모드로 보유할 수 있음.
+ * 쓰기 대기자가 있으면 새 reader는 기다리며 (Writer preference), 대기자들의 우선순위는 모든 소유자에게 기부됨. */
+struct rwlock {
+    struct thread *writer;      /* 배타 모드 소유자 (없으면 NULL). */
+    struct list readers;        /* 공유 모드 소유자들의 struct rw_hold. */
+    struct waitqueue read_waiters;  /* 공유 모드를 기다리는 스레드들. */
+    struct waitqueue write_waiters; /* 배타 모드를 기다리는 스레드들. */
+    int waiting_writers;        /* 배타 모드를 기다리는 (깨어났지만 아직 확보 전인 경우 포함) 스레드 수. */
+    struct heap donors;         /* 기다리는 모든 스레드들, 가장 높은 우선순위가 top. */
+};
+
+/* 스레드가 보유한 rwlock 하나 (struct thread의 rw_holds 배열 원소 ; 비어 있다면 rwlock이 NULL). */
+struct rw_hold {
+    struct rwlock *rwlock;      /* 보유 중인 rwlock. */
+    struct thread *holder;      /* 보유한 스레드. */
+    struct list_elem elem;      /* rwlock->readers의 elem (공유 모드일 때). */
+};
+
+/* 한 스레드가 동시에 보유할 수 있는 rwlock 수 */
+#define RW_HOLD_MAX 8
+
+void rwlock_init(struct rwlock *);
+void rwlock_acquire_read(struct rwlock *);
+void rwlock_release_read(struct rwlock *);
+void rwlock_acquire_write(struct rwlock *);
+void rwlock_release_write(struct rwlock *);
+bool rwlock_held_by_current_thread(const struct rwlock *);
+int rwlock_donated_priority(const struct rwlock *);
 
 /* Condition variable. */
 struct condition {
-    struct list waiters; /* List of waiting threads. */
+    struct waitqueue waiters; /* Waiting threads. */
 };
 
 void cond_init(struct condition *);
 void cond_wait(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
+void cond_set_owner(struct condition *, struct thread *);
 
 /* Optimization barrier.
  *
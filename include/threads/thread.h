@@ -6,6 +6,9 @@
 #include <list.h>
 #include <stdint.h>
 #include <hash.h> // SPT 해시테이블을 위해서 추가
+#include <heap.h> // sleep_heap을 위해서 추가
+#include <rusage.h> // 스레드별 자원 사용량 통계
+#include "threads/fixed-point.h" // MLFQS의 recent_cpu, load_avg 계산용
 #include "threads/interrupt.h"
 #include "threads/synch.h" // fd_lock을 스레드마다 구현하기 위함
 
@@ -38,6 +41,11 @@ typedef int pid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63     /* Highest priority. */
 
+/* MLFQS nice 값의 범위. */
+#define NICE_MIN -20    /* Nicest to other threads. */
+#define NICE_DEFAULT 0  /* Default nice value. */
+#define NICE_MAX 20     /* Least nice to other threads. */
+
 /* (Updated) A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -90,11 +98,13 @@ typedef int pid_t;
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * the run queue (thread.c), or it can be an element in the
+ * destruction request list (thread.c).  It can be used these two
+ * ways only because they are mutually exclusive: only a thread in
+ * the ready state is on the run queue, whereas only a dying
+ * thread is on the destruction request list.  Threads waiting on
+ * a semaphore, condition variable or rwlock are kept in a
+ * waitqueue through `wait_elem' instead (synch.c). */
 struct thread {
     tid_t tid;                 /* Thread identifier 번호 */
     enum thread_status status; /* Thread state (RUNNING 등) */
@@ -102,13 +112,45 @@ struct thread {
     int priority;              /* Priority (함수들이 참고하는 실제 우선순위) */
 
     /* Alarm Clock 구현을 위해서 추가 */
-    int64_t wake_tick; // 스레드가 Sleep된다면, 깨어나야 할 System Tick 수치를 여기에 저장
+    int64_t wake_tick;            // 스레드가 Sleep된다면, 깨어나야 할 System Tick 수치를 여기에 저장
+    struct heap_elem sleep_elem; // Sleep 상태일 때 sleep_heap에 삽입되는 elem (wake_tick 기준 min-heap)
 
     /* Priority Donation을 위한 멤버들 */
     int priority_original;          // 최초 부여된 우선순위를 저장하는 부분 (Donation이 다 끝났을 때 참고 목적)
     struct lock *waiting_for_lock;  // 스레드가 특정 락을 기다리고 있을 경우 여기에 저장
-    struct list donations;          // 다른 스레드가 우선순위를 기부했을 경우 여기에 저장
-    struct list_elem donation_elem; // 우선순위를 기부할 경우 이 포인터를 해당 스레드의 donations 리스트에 저장
+    struct heap held_locks;         // 보유 중인 락들의 max-heap (각 락을 기다리는 스레드들의 최고 우선순위 기준)
+    struct heap_elem donor_elem;    // waiting_for_lock (또는 waiting_for_rwlock)의 donors heap (기다리는 스레드들의 max-heap)에 삽입되는 elem
+    struct rwlock *waiting_for_rwlock;   // 스레드가 특정 rwlock을 기다리고 있을 경우 여기에 저장
+    struct rw_hold rw_holds[RW_HOLD_MAX]; // 보유 중인 rwlock들 (각 rwlock의 donors도 Donation 계산에 포함)
+
+    /* 우선순위 대기열 (synch.c)을 위한 멤버들 */
+    struct waitqueue *waitqueue; // 기다리고 있는 waitqueue (없다면 NULL)
+    struct heap_elem wait_elem;  // waitqueue의 waiters heap에 삽입되는 elem
+    unsigned wait_seq;           // waitqueue에 들어간 순번 (같은 우선순위끼리 FIFO 목적)
+    struct heap owned_queues;    // owner로 지정된 waitqueue들의 max-heap (기다리는 스레드들의 최고 우선순위 기준)
+
+    /* MLFQS를 위한 멤버들 */
+    int nice;            // 다른 스레드에게 CPU를 양보하는 정도 (-20 ~ 20)
+    fixed_t recent_cpu;  // 최근에 사용한 CPU 시간 (17.14 fixed-point)
+    struct list_elem all_elem; // 모든 스레드를 담는 all_list에 삽입 (1초마다 일괄 갱신 목적)
+
+    /* EDF 스케쥴링 클래스를 위한 멤버들 (edf_period가 0이면 EDF 클래스가 아님) */
+    int64_t edf_period;               // 주기 (Timer Tick 단위)
+    int64_t edf_runtime;              // 주기마다 보장받는 실행 시간 (Timer Tick 단위)
+    int64_t edf_deadline;             // 현재 주기의 마감 시점 (절대 Tick)
+    int64_t edf_budget;               // 현재 주기에 남은 실행 시간 ; 0이면 다음 주기까지 우선순위 클래스로 강등
+    bool edf_queued;                  // READY 상태에서 ready_queue 대신 edf_ready_heap에 들어가 있다면 true
+    struct heap_elem edf_elem;        // READY 상태일 때 edf_ready_heap에 삽입되는 elem
+    struct heap_elem edf_member_elem; // EDF 클래스인 동안 edf_member_heap에 삽입되는 elem (주기 갱신 목적)
+    long long edf_misses;             // 실행 가능한 상태로 runtime을 다 받지 못하고 마감을 넘긴 횟수
+
+    /* 스레드별 자원 사용량 통계 (rdtsc 단위) */
+    struct rusage rusage; // RUNNING/READY/BLOCKED 누적 시간 및 Context switch 횟수
+    uint64_t state_since; // 현재 상태 (RUNNING/READY/BLOCKED)에 진입한 시점의 TSC 값
+
+    /* malloc()의 작은 크기 클래스별로 이 스레드가 해제한 블록을 모아두는 캐시 ; 락 없이 할당/해제
+       커널 스택과 페이지를 나눠 쓰므로 여기엔 포인터만 두고, 처음 쓸 때 할당해 malloc_drain()에서 해제 */
+    struct magazines *magazines;
 
     struct list_elem elem; /* 원래 포함되어 있는, 가장 기본적인 thread elem */
 
@@ -147,6 +189,7 @@ struct thread {
 
     /* Owned by thread.c. */
     struct intr_frame tf; /* Information for switching */
+    uint64_t switch_rsp;  /* switch_fast()로 멈췄다면 그때의 커널 스택 포인터, 아니면 0 */
     unsigned magic;       /* Detects stack overflow. */
 };
 
@@ -155,11 +198,17 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* false면 모든 Context switch를 intr_frame 전체 저장/복원 (iretq) 경로로 수행 (벤치마크 비교용) */
+extern bool thread_fast_switch;
+
 void thread_init(void);
 void thread_start(void);
 
-void thread_tick(void);
+void thread_tick(int64_t tick);
 void thread_print_stats(void);
+void thread_print_page_caches(void);
+void thread_print_rusage(void);
+void thread_get_rusage(struct rusage *);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
@@ -177,6 +226,9 @@ void thread_yield(void);
 int thread_get_priority(void);
 void thread_set_priority(int);
 
+bool thread_set_deadline(int64_t period, int64_t runtime);
+long long thread_get_deadline_misses(void);
+
 int thread_get_nice(void);
 void thread_set_nice(int);
 int thread_get_recent_cpu(void);
@@ -187,10 +239,12 @@ void do_iret(struct intr_frame *tf);
 /* 최초 버전 대비 직접 추가한 함수 프로토타입들 */
 
 void thread_sleep(int64_t wake_time_tick);
+void thread_sleep_cancel(struct thread *);
 void thread_wake(int64_t current_tick);
-bool comparison_for_sleeplist_insertion(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED);
-bool comparison_for_readylist_insertion(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED);
-bool comparison_for_priority_donation(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED);
+int64_t thread_next_wake_tick(void);
+int64_t thread_ticks_left(void);
+bool comparison_for_sleepheap_insertion(const struct heap_elem *new, const struct heap_elem *existing, void *aux UNUSED);
+void thread_refresh_priority(struct thread *);
 void thread_check_yield(void);
 
 #endif /* threads/thread.h */
@@ -0,0 +1,45 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 스케쥴링 이벤트 트레이스 (Context switch 및 Wakeup을 고정 크기 Ring buffer에 기록).
+ * printf는 console lock을 거치며 타이밍을 왜곡하니, 이벤트마다 24바이트 레코드만 남기고
+ * 종료 시 (또는 trace_dump() 호출 시) Serial 포트로 덤프 ; utils/trace-decode로 해석. */
+
+/* 이벤트 종류 */
+enum trace_type {
+    TRACE_SWITCH = 1, /* schedule() ; tid → other로 Context switch */
+    TRACE_UNBLOCK,    /* thread_unblock() ; tid가 other를 깨움 */
+    TRACE_SEMA_UP     /* sema_up() ; tid가 arg 주소의 세마포어를 올리고 other를 깨움 (없으면 0) */
+};
+
+/* TRACE_SWITCH의 전환 사유 */
+enum trace_reason {
+    TRACE_BLOCK = 1, /* 이전 스레드가 Block 됨 */
+    TRACE_YIELD,     /* 이전 스레드가 양보 (우선순위 Preemption 포함) */
+    TRACE_SLICE,     /* 이전 스레드가 Time slice를 다 써서 밀려남 */
+    TRACE_EXIT       /* 이전 스레드가 종료됨 */
+};
+
+/* Ring buffer에 기록되는 레코드 (덤프되는 바이너리 포맷과 동일 ; little-endian 24바이트) */
+struct trace_event {
+    uint64_t tsc;   /* 이벤트 발생 시점의 rdtsc 값 */
+    int32_t tid;    /* 이벤트를 일으킨 (또는 CPU를 내준) 스레드 */
+    int32_t other;  /* 다음 스레드 또는 깨어난 스레드 */
+    uint8_t type;   /* enum trace_type */
+    uint8_t status; /* TRACE_SWITCH : 이전 스레드의 새 상태 (enum thread_status) */
+    uint8_t reason; /* TRACE_SWITCH : enum trace_reason */
+    uint8_t intr;   /* Interrupt Handler 안에서 발생했다면 1 */
+    uint32_t arg;   /* TRACE_SEMA_UP : 세마포어 주소의 하위 32비트, TRACE_SWITCH : 다음 스레드의 우선순위 */
+};
+
+extern bool trace_enabled;
+
+void trace_init(void);
+void trace_record(enum trace_type, int32_t tid, int32_t other, uint8_t status, uint8_t reason, uint32_t arg);
+void trace_thread_name(int32_t tid, const char *name);
+void trace_dump(void);
+
+#endif /* threads/trace.h */
@@ -0,0 +1,11 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include <futex.h>
+#include <stdint.h>
+
+void futex_init(void);
+int futex_queue_wait(int *kaddr, int expected, int64_t timeout);
+int futex_queue_wake(int *kaddr, int n);
+
+#endif /* userprog/futex.h */
@@ -62,6 +62,57 @@ last_mask (const struct bitmap *b) {
 	int last_bits = b->bit_cnt % ELEM_BITS;
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns a mask of the bits in element IDX that are numbered
+   from START to END, exclusive, in the bitmap. */
+static inline elem_type
+range_mask (size_t idx, size_t start, size_t end) {
+	size_t first = idx * ELEM_BITS;
+	elem_type mask = (elem_type) -1;
+
+	if (start > first)
+		mask &= (elem_type) -1 << (start - first);
+	if (end < first + ELEM_BITS)
+		mask &= ((elem_type) 1 << (end - first)) - 1;
+	return mask;
+}
+
+/* Returns the number of bits set in X. */
+static inline size_t
+popcount (elem_type x) {
+	x = x - ((x >> 1) & 0x5555555555555555UL);
+	x = (x & 0x3333333333333333UL) + ((x >> 2) & 0x3333333333333333UL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+	return (x * 0x0101010101010101UL) >> 56;
+}
+
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE, or B's size if there is none.  Skips whole
+   elements that have no such bit. */
+static size_t
+find_next (const struct bitmap *b, size_t start, bool value) {
+	elem_type flip = value ? 0 : (elem_type) -1;
+	size_t idx, last;
+	elem_type bits;
+
+	if (start >= b->bit_cnt)
+		return b->bit_cnt;
+
+	/* Flip the bits so that the ones we want are 1s, then skip
+	   elements that are all 0s. */
+	idx = elem_idx (start);
+	last = elem_cnt (b->bit_cnt) - 1;
+	bits = (b->bits[idx] ^ flip) & ((elem_type) -1 << (start % ELEM_BITS));
+	while (bits == 0) {
+		if (idx == last)
+			return b->bit_cnt;
+		bits = b->bits[++idx] ^ flip;
+	}
+
+	/* The unused bits of the last element may look like a match. */
+	start = idx * ELEM_BITS + __builtin_ctzl (bits);
+	return start < b->bit_cnt ? start : b->bit_cnt;
+}
 
 /* Creation and destruction. */
 
@@ -194,7 +245,9 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, as in bitmap_mark() and
+   bitmap_reset(). */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
 	size_t i;
@@ -203,41 +256,44 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	if (cnt == 0)
+		return;
+	for (i = elem_idx (start); i <= elem_idx (start + cnt - 1); i++) {
+		elem_type mask = range_mask (i, start, start + cnt);
+		if (value)
+			asm ("lock orq %1, %0" : "=m" (b->bits[i]) : "r" (mask) : "cc");
+		else
+			asm ("lock andq %1, %0" : "=m" (b->bits[i]) : "r" (~mask) : "cc");
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i, value_cnt;
+	size_t i, true_cnt;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			value_cnt++;
-	return value_cnt;
+	if (cnt == 0)
+		return 0;
+	true_cnt = 0;
+	for (i = elem_idx (start); i <= elem_idx (start + cnt - 1); i++)
+		true_cnt += popcount (b->bits[i] & range_mask (i, start, start + cnt));
+	return value ? true_cnt : cnt - true_cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			return true;
-	return false;
+	return cnt > 0 && find_next (b, start, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -266,18 +322,36 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+
+   Works a run at a time rather than a bit at a time: it finds
+   the next bit set to VALUE, then the next bit after that set to
+   !VALUE, and either the run between them is long enough or the
+   search resumes at its end.  Both searches skip whole elements,
+   so the cost is proportional to the number of elements and runs
+   passed over rather than to the number of bits times CNT. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
+	if (cnt == 0)
+		return start;
 	if (cnt <= b->bit_cnt) {
 		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
+		size_t i = start;
+
+		while (i <= last) {
+			size_t end;
+
+			i = find_next (b, i, value);
+			if (i > last)
+				break;
+			end = find_next (b, i, !value);
+			if (end - i >= cnt)
 				return i;
+			i = end;
+		}
 	}
 	return BITMAP_ERROR;
 }
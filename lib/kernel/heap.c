@@ -0,0 +1,229 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* Our heap is a complete binary tree whose nodes are the
+   embedded heap_elems themselves.  Elements are numbered from 1
+   in level order, so the root is element 1, its children are
+   elements 2 and 3, and in general element N has children 2N
+   and 2N + 1.  Because the tree is always complete, the last
+   element (number SIZE) is where a new element is attached and
+   where a replacement for a removed element is taken from.
+
+   Moving an element up or down the tree means relinking it with
+   its parent rather than copying data around, so elements never
+   move in memory and a pointer to an element stays valid for as
+   long as the element is in the heap. */
+
+static struct heap_elem *locate (struct heap *, size_t idx);
+static void replace (struct heap *, struct heap_elem *old,
+		struct heap_elem *new);
+static void swap_with_parent (struct heap *, struct heap_elem *);
+static void sift_up (struct heap *, struct heap_elem *);
+static void sift_down (struct heap *, struct heap_elem *);
+
+/* Initializes HEAP as an empty heap ordered by LESS given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->root = NULL;
+	heap->size = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+heap_push (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->left = elem->right = NULL;
+	if (heap->size++ == 0) {
+		elem->parent = NULL;
+		heap->root = elem;
+		return;
+	}
+
+	/* Attach ELEM as element number SIZE, then move it up. */
+	elem->parent = locate (heap, heap->size / 2);
+	if (heap->size % 2 == 0)
+		elem->parent->left = elem;
+	else
+		elem->parent->right = elem;
+	sift_up (heap, elem);
+}
+
+/* Returns the minimum element of HEAP, or a null pointer if
+   HEAP is empty. */
+struct heap_elem *
+heap_top (struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->root;
+}
+
+/* Removes and returns the minimum element of HEAP, or returns a
+   null pointer if HEAP is empty. */
+struct heap_elem *
+heap_pop (struct heap *heap) {
+	struct heap_elem *top = heap_top (heap);
+
+	if (top != NULL)
+		heap_remove (heap, top);
+	return top;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem) {
+	struct heap_elem *last;
+
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+	ASSERT (heap->size > 0);
+
+	/* Detach the last element from the tree. */
+	last = locate (heap, heap->size);
+	if (last->parent == NULL)
+		heap->root = NULL;
+	else if (last->parent->left == last)
+		last->parent->left = NULL;
+	else
+		last->parent->right = NULL;
+	heap->size--;
+
+	/* Put it where ELEM was and let it settle. */
+	if (last != elem) {
+		replace (heap, elem, last);
+		sift_up (heap, last);
+		sift_down (heap, last);
+	}
+	elem->parent = elem->left = elem->right = NULL;
+}
+
+/* Restores the heap property after the key of ELEM, which must
+   be in HEAP, has changed in either direction. */
+void
+heap_update (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	sift_up (heap, elem);
+	sift_down (heap, elem);
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->size;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+heap_empty (struct heap *heap) {
+	return heap_size (heap) == 0;
+}
+
+/* Returns element number IDX of HEAP, where 1 <= IDX <= SIZE. */
+static struct heap_elem *
+locate (struct heap *heap, size_t idx) {
+	struct heap_elem *e = heap->root;
+	int bit;
+
+	ASSERT (idx >= 1 && idx <= heap->size);
+
+	/* The bits of IDX below its most significant set bit spell
+	   out the path from the root: 0 for left, 1 for right. */
+	for (bit = 62 - __builtin_clzll (idx); bit >= 0; bit--)
+		e = (idx >> bit) & 1 ? e->right : e->left;
+	return e;
+}
+
+/* Puts NEW, which is not in HEAP, in the tree position of OLD. */
+static void
+replace (struct heap *heap, struct heap_elem *old, struct heap_elem *new) {
+	new->parent = old->parent;
+	new->left = old->left;
+	new->right = old->right;
+
+	if (new->parent == NULL)
+		heap->root = new;
+	else if (new->parent->left == old)
+		new->parent->left = new;
+	else
+		new->parent->right = new;
+	if (new->left != NULL)
+		new->left->parent = new;
+	if (new->right != NULL)
+		new->right->parent = new;
+}
+
+/* Exchanges the tree positions of ELEM and its parent. */
+static void
+swap_with_parent (struct heap *heap, struct heap_elem *elem) {
+	struct heap_elem *parent = elem->parent;
+	struct heap_elem *grand = parent->parent;
+	struct heap_elem *left = elem->left;
+	struct heap_elem *right = elem->right;
+
+	/* ELEM takes over PARENT's children, with PARENT in its own
+	   former slot. */
+	if (parent->left == elem) {
+		elem->left = parent;
+		elem->right = parent->right;
+		if (elem->right != NULL)
+			elem->right->parent = elem;
+	} else {
+		elem->right = parent;
+		elem->left = parent->left;
+		if (elem->left != NULL)
+			elem->left->parent = elem;
+	}
+
+	/* PARENT takes over ELEM's children. */
+	parent->left = left;
+	parent->right = right;
+	if (left != NULL)
+		left->parent = parent;
+	if (right != NULL)
+		right->parent = parent;
+
+	/* Hook ELEM into PARENT's former place. */
+	parent->parent = elem;
+	elem->parent = grand;
+	if (grand == NULL)
+		heap->root = elem;
+	else if (grand->left == parent)
+		grand->left = elem;
+	else
+		grand->right = elem;
+}
+
+/* Moves ELEM toward the root while it is less than its parent. */
+static void
+sift_up (struct heap *heap, struct heap_elem *elem) {
+	while (elem->parent != NULL
+			&& heap->less (elem, elem->parent, heap->aux))
+		swap_with_parent (heap, elem);
+}
+
+/* Moves ELEM toward the leaves while a child is less than it. */
+static void
+sift_down (struct heap *heap, struct heap_elem *elem) {
+	for (;;) {
+		struct heap_elem *min = elem;
+
+		if (elem->left != NULL
+				&& heap->less (elem->left, min, heap->aux))
+			min = elem->left;
+		if (elem->right != NULL
+				&& heap->less (elem->right, min, heap->aux))
+			min = elem->right;
+		if (min == elem)
+			break;
+		swap_with_parent (heap, min);
+	}
+}
@@ -0,0 +1,133 @@
+#include <synch.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* Atomically replaces *P by NEW if it holds *OLD and returns
+   true; otherwise stores the value found in *OLD and returns
+   false. */
+static inline bool
+cas (int *p, int *old, int new) {
+	return __atomic_compare_exchange_n (p, old, new, false,
+	                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/* Initializes mutex M to unlocked. */
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+/* Acquires mutex M, sleeping in the kernel only if another
+   thread holds it.  This is the three-state mutex from Ulrich
+   Drepper's "Futexes Are Tricky": an unlocker only has to call
+   futex_wake() if the state says someone may be waiting. */
+void
+mutex_lock (struct mutex *m) {
+	int c = 0;
+
+	if (cas (&m->state, &c, 1))
+		return;
+
+	/* Mark the mutex as contended, then sleep until we are the
+	   one who finds it unlocked. */
+	if (c != 2)
+		c = __atomic_exchange_n (&m->state, 2, __ATOMIC_SEQ_CST);
+	while (c != 0) {
+		futex_wait (&m->state, 2, 0);
+		c = __atomic_exchange_n (&m->state, 2, __ATOMIC_SEQ_CST);
+	}
+}
+
+/* Acquires mutex M if it is unlocked and returns true, or
+   returns false without waiting. */
+bool
+mutex_trylock (struct mutex *m) {
+	int c = 0;
+
+	return cas (&m->state, &c, 1);
+}
+
+/* Releases mutex M, which the caller must hold. */
+void
+mutex_unlock (struct mutex *m) {
+	if (__atomic_fetch_sub (&m->state, 1, __ATOMIC_SEQ_CST) != 1) {
+		__atomic_store_n (&m->state, 0, __ATOMIC_SEQ_CST);
+		futex_wake (&m->state, 1);
+	}
+}
+
+/* Initializes condition variable C. */
+void
+condvar_init (struct condvar *c) {
+	c->seq = 0;
+	c->waiters = 0;
+}
+
+/* Atomically releases M and waits for C to be signaled, then
+   reacquires M.  As with the kernel's condition variables, the
+   caller must recheck its condition after waking. */
+void
+condvar_wait (struct condvar *c, struct mutex *m) {
+	int seq = __atomic_load_n (&c->seq, __ATOMIC_SEQ_CST);
+
+	/* A signal between the unlock and the futex_wait() bumps SEQ,
+	   so futex_wait() returns at once instead of missing it. */
+	__atomic_fetch_add (&c->waiters, 1, __ATOMIC_SEQ_CST);
+	mutex_unlock (m);
+	futex_wait (&c->seq, seq, 0);
+	__atomic_fetch_sub (&c->waiters, 1, __ATOMIC_SEQ_CST);
+	mutex_lock (m);
+}
+
+/* Wakes one thread waiting on C, if any. */
+void
+condvar_signal (struct condvar *c) {
+	__atomic_fetch_add (&c->seq, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n (&c->waiters, __ATOMIC_SEQ_CST) > 0)
+		futex_wake (&c->seq, 1);
+}
+
+/* Wakes every thread waiting on C. */
+void
+condvar_broadcast (struct condvar *c) {
+	__atomic_fetch_add (&c->seq, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n (&c->waiters, __ATOMIC_SEQ_CST) > 0)
+		futex_wake (&c->seq, INT_MAX);
+}
+
+/* Initializes semaphore S to VALUE. */
+void
+sema_init (struct semaphore *s, int value) {
+	s->value = value;
+	s->waiters = 0;
+}
+
+/* Waits for S's value to become positive and decrements it. */
+void
+sema_down (struct semaphore *s) {
+	while (!sema_try_down (s)) {
+		__atomic_fetch_add (&s->waiters, 1, __ATOMIC_SEQ_CST);
+		futex_wait (&s->value, 0, 0);
+		__atomic_fetch_sub (&s->waiters, 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+/* Decrements S's value if it is positive and returns true, or
+   returns false without waiting. */
+bool
+sema_try_down (struct semaphore *s) {
+	int v = __atomic_load_n (&s->value, __ATOMIC_SEQ_CST);
+
+	while (v > 0)
+		if (cas (&s->value, &v, v - 1))
+			return true;
+	return false;
+}
+
+/* Increments S's value and wakes one waiter, if any. */
+void
+sema_up (struct semaphore *s) {
+	__atomic_fetch_add (&s->value, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n (&s->waiters, __ATOMIC_SEQ_CST) > 0)
+		futex_wake (&s->value, 1);
+}
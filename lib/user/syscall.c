@@ -78,6 +78,12 @@ void close(int fd) { syscall1(SYS_CLOSE, fd); }
 
 int dup2(int oldfd, int newfd) { return syscall2(SYS_DUP2, oldfd, newfd); }
 
+int getrusage(struct rusage *usage) { return syscall1(SYS_GETRUSAGE, usage); }
+
+int futex_wait(int *addr, int expected, int64_t timeout) { return syscall3(SYS_FUTEX_WAIT, addr, expected, timeout); }
+
+int futex_wake(int *addr, int n) { return syscall2(SYS_FUTEX_WAKE, addr, n); }
+
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) { return (void *)syscall5(SYS_MMAP, addr, length, writable, fd, offset); }
 
 void munmap(void *addr) { syscall1(SYS_MUNMAP, addr); }
@@ -0,0 +1,130 @@
+/* Puts 5,000 threads to sleep at once, each until a different
+   tick spread over a few seconds, and verifies that they all wake
+   up, none early, and in order of their wake-up ticks.  Also
+   reports the worst-case duration of the timer interrupt handler
+   with all of the sleepers queued, next to the same measurement
+   with no sleepers at all. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of sleeping threads. */
+#define SLEEPER_CNT 5000
+
+/* Wake-up ticks are spread over this many ticks. */
+#define WAKE_SPREAD 500
+
+/* Information about the test. */
+struct stress_test
+  {
+    int64_t start;              /* Sleepers wake up after this tick. */
+    struct semaphore done;      /* Upped once by each sleeper. */
+    int64_t *output_pos;        /* Current position in output buffer. */
+    int early_cnt;              /* Sleepers that woke up too early. */
+  };
+
+/* Information about an individual sleeper. */
+struct stress_sleeper
+  {
+    struct stress_test *test;   /* Info shared between all threads. */
+    int64_t wake_tick;          /* Tick to wake up at. */
+  };
+
+static void sleeper (void *);
+
+void
+test_alarm_stress (void)
+{
+  struct stress_test test;
+  struct stress_sleeper *sleepers;
+  int64_t *output;
+  uint64_t idle_cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Creating %d threads to sleep at once, waking over %d ticks.",
+       SLEEPER_CNT, WAKE_SPREAD);
+
+  /* Allocate memory. */
+  sleepers = malloc (sizeof *sleepers * SLEEPER_CNT);
+  output = malloc (sizeof *output * SLEEPER_CNT);
+  if (sleepers == NULL || output == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  /* Measure the handler with an empty sleep queue. */
+  timer_sleep (1);
+  timer_reset_interrupt_stats ();
+  timer_sleep (50);
+  idle_cycles = timer_max_interrupt_cycles ();
+
+  /* Start threads.  They have lower priority than us, so none of
+     them runs before we block, by which time test.start is set. */
+  sema_init (&test.done, 0);
+  test.output_pos = output;
+  test.early_cnt = 0;
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      struct stress_sleeper *s = &sleepers[i];
+      char name[16];
+
+      s->test = &test;
+      s->wake_tick = 1 + (i * 7919) % WAKE_SPREAD;
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT - 1, sleeper, s) == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+  test.start = timer_ticks () + 200;
+
+  /* Wait for every sleeper to wake up. */
+  timer_reset_interrupt_stats ();
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_down (&test.done);
+
+  msg ("worst-case timer interrupt, no sleepers: %llu cycles",
+       idle_cycles);
+  msg ("worst-case timer interrupt, %d sleepers: %llu cycles",
+       SLEEPER_CNT, timer_max_interrupt_cycles ());
+
+  /* Verify wake-up order. */
+  if (test.early_cnt != 0)
+    fail ("%d sleepers woke up early", test.early_cnt);
+  if (test.output_pos - output != SLEEPER_CNT)
+    fail ("%d sleepers woke up, expected %d",
+          (int) (test.output_pos - output), SLEEPER_CNT);
+  for (i = 1; i < SLEEPER_CNT; i++)
+    if (output[i] < output[i - 1])
+      fail ("sleeper waking at tick %lld ran after one waking at %lld",
+            output[i], output[i - 1]);
+  msg ("All %d sleepers woke up in order.", SLEEPER_CNT);
+
+  free (output);
+  free (sleepers);
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *s_)
+{
+  struct stress_sleeper *s = s_;
+  struct stress_test *test = s->test;
+  int64_t wake_tick = test->start + s->wake_tick;
+  enum intr_level old_level;
+
+  timer_sleep (wake_tick - timer_ticks ());
+
+  old_level = intr_disable ();
+  if (timer_ticks () < wake_tick)
+    test->early_cnt++;
+  *test->output_pos++ = wake_tick;
+  intr_set_level (old_level);
+
+  sema_up (&test->done);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Drop the timing lines, which differ from run to run.
+our ($test);
+my (@output) = grep (!/ cycles$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(alarm-stress) begin
+(alarm-stress) Creating 5000 threads to sleep at once, waking over 500 ticks.
+(alarm-stress) All 5000 sleepers woke up in order.
+(alarm-stress) end
+EOF
+pass;
@@ -0,0 +1,67 @@
+/* Fills a 1M-bit bitmap to several levels with randomly placed
+   set bits and reports the cycles bitmap_scan() takes to find
+   the first run of 1, 8 and 64 clear bits.  Each result is
+   checked against a bit-at-a-time walk over the map. */
+
+#include <bitmap.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "intrinsic.h"
+
+/* Number of bits in the map. */
+#define BIT_CNT (1024 * 1024)
+
+static void check_scan (struct bitmap *, size_t cnt, size_t idx);
+
+void
+test_bitmap_bench (void) 
+{
+  static const int fills[] = {0, 50, 90, 99};
+  static const size_t cnts[] = {1, 8, 64};
+  struct bitmap *b;
+  size_t i, j, k;
+
+  b = bitmap_create (BIT_CNT);
+  if (b == NULL)
+    fail ("bitmap_create failed");
+  random_init (0);
+
+  for (i = 0; i < sizeof fills / sizeof *fills; i++) 
+    {
+      bitmap_set_all (b, false);
+      for (k = 0; k < BIT_CNT; k++)
+        if (random_ulong () % 100 < (unsigned) fills[i])
+          bitmap_mark (b, k);
+
+      for (j = 0; j < sizeof cnts / sizeof *cnts; j++) 
+        {
+          uint64_t start = rdtsc ();
+          size_t idx = bitmap_scan (b, 0, cnts[j], false);
+          uint64_t cycles = rdtsc () - start;
+
+          check_scan (b, cnts[j], idx);
+          msg ("%d%% full, %zu clear bits: %llu cycles",
+               fills[i], cnts[j], cycles);
+        }
+    }
+  bitmap_destroy (b);
+  msg ("All scans matched.");
+}
+
+/* Checks that IDX is where the first run of CNT clear bits in B
+   starts, or BITMAP_ERROR if there is no such run. */
+static void
+check_scan (struct bitmap *b, size_t cnt, size_t idx) 
+{
+  size_t run = 0, i;
+
+  for (i = 0; i < BIT_CNT; i++) 
+    {
+      run = bitmap_test (b, i) ? 0 : run + 1;
+      if (run == cnt)
+        break;
+    }
+  if (i == BIT_CNT ? idx != BITMAP_ERROR : idx != i + 1 - cnt)
+    fail ("scan for %zu clear bits returned %zu", cnt, idx);
+}
@@ -0,0 +1,80 @@
+/* Checks the EDF scheduling class: an EDF thread runs ahead of
+   a PRI_MAX thread, admission control rejects a thread that
+   would push total utilization over 1, an EDF thread runs as
+   soon as the EDF thread ahead of it leaves the class, and a
+   thread that uses up its budget is demoted until its next
+   period. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func hog;
+static thread_func joiner;
+
+static struct semaphore joined;
+static bool hog_ran;
+static bool over_admitted;
+static bool admitted;
+static bool joiner_done;
+
+void
+test_edf_basic (void) 
+{
+  int64_t start;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Joining EDF at 60%% utilization: %s.",
+       thread_set_deadline (1000, 600) ? "admitted" : "rejected");
+
+  /* The PRI_MAX thread must wait until we block. */
+  thread_create ("hog", PRI_MAX, hog, NULL);
+  msg ("PRI_MAX thread ran ahead of EDF thread: %s.", hog_ran ? "yes" : "no");
+
+  sema_init (&joined, 0);
+  thread_create ("joiner", PRI_DEFAULT + 1, joiner, NULL);
+  sema_down (&joined);
+  msg ("Second thread joining at 50%%: %s.",
+       over_admitted ? "admitted" : "rejected");
+  msg ("Second thread joining at 40%%: %s.",
+       admitted ? "admitted" : "rejected");
+
+  /* The other EDF thread is ready, so leaving EDF lets it run. */
+  thread_set_deadline (0, 0);
+  msg ("Other EDF thread ran once we left EDF: %s.",
+       joiner_done ? "yes" : "no");
+
+  /* With a 2-tick budget, spinning for 5 ticks gets us demoted,
+     which lets a PRI_MAX thread in. */
+  hog_ran = false;
+  msg ("Joining EDF with a 2-tick budget: %s.",
+       thread_set_deadline (20, 2) ? "admitted" : "rejected");
+  thread_create ("hog", PRI_MAX, hog, NULL);
+  start = timer_ticks ();
+  while (timer_elapsed (start) < 5)
+    continue;
+  msg ("PRI_MAX thread ran once the budget was used up: %s.",
+       hog_ran ? "yes" : "no");
+  msg ("Deadline misses: %lld.", thread_get_deadline_misses ());
+  thread_set_deadline (0, 0);
+}
+
+static void
+hog (void *aux UNUSED) 
+{
+  hog_ran = true;
+}
+
+static void
+joiner (void *aux UNUSED) 
+{
+  over_admitted = thread_set_deadline (1000, 500);
+  admitted = thread_set_deadline (1000, 400);
+  sema_up (&joined);
+  joiner_done = true;
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-basic) begin
+(edf-basic) Joining EDF at 60% utilization: admitted.
+(edf-basic) PRI_MAX thread ran ahead of EDF thread: no.
+(edf-basic) Second thread joining at 50%: rejected.
+(edf-basic) Second thread joining at 40%: admitted.
+(edf-basic) Other EDF thread ran once we left EDF: yes.
+(edf-basic) Joining EDF with a 2-tick budget: admitted.
+(edf-basic) PRI_MAX thread ran once the budget was used up: yes.
+(edf-basic) Deadline misses: 0.
+(edf-basic) end
+EOF
+pass;
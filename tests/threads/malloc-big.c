@@ -0,0 +1,113 @@
+/* Allocates big blocks of many sizes from malloc(), frees every
+   other one and allocates into the holes, checking that no block
+   overwrites another.  Then reports the cycles per malloc() and
+   free() pair for a small block, for big blocks of one and of
+   five pages, and for getting the same pages straight from the
+   page allocator. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "intrinsic.h"
+
+/* Number of big blocks. */
+#define BLOCK_CNT 32
+
+/* Number of timed malloc() and free() pairs. */
+#define ITER_CNT 256
+
+static uint8_t *blocks[BLOCK_CNT];
+static size_t sizes[BLOCK_CNT];
+
+static void alloc_block (int i, size_t size);
+static void check_block (int i);
+static uint64_t time_malloc (size_t size);
+static uint64_t time_palloc (size_t page_cnt);
+
+void
+test_malloc_big (void) 
+{
+  int i;
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    alloc_block (i, 2100 + i * 1500);
+  for (i = 0; i < BLOCK_CNT; i += 2) 
+    {
+      check_block (i);
+      free (blocks[i]);
+    }
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    alloc_block (i, 2100 + (BLOCK_CNT - i) * 700);
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      check_block (i);
+      free (blocks[i]);
+    }
+  msg ("Big blocks did not overlap.");
+
+  msg ("Malloc 64 bytes: %llu cycles", time_malloc (64));
+  msg ("Malloc 1 page: %llu cycles", time_malloc (2100));
+  msg ("Malloc 5 pages: %llu cycles", time_malloc (5 * 4096 - 100));
+  msg ("Palloc 1 page: %llu cycles", time_palloc (1));
+  msg ("Palloc 5 pages: %llu cycles", time_palloc (5));
+}
+
+/* Allocates BLOCKS[I] with SIZE bytes and fills it with I. */
+static void
+alloc_block (int i, size_t size) 
+{
+  blocks[i] = malloc (size);
+  if (blocks[i] == NULL)
+    fail ("malloc (%zu) failed", size);
+  sizes[i] = size;
+  memset (blocks[i], i, size);
+}
+
+/* Checks that BLOCKS[I] still holds I in every byte. */
+static void
+check_block (int i) 
+{
+  size_t j;
+
+  for (j = 0; j < sizes[i]; j++)
+    if (blocks[i][j] != i)
+      fail ("block %d of %zu bytes was overwritten at byte %zu",
+            i, sizes[i], j);
+}
+
+/* Returns the cycles per malloc() and free() of SIZE bytes. */
+static uint64_t
+time_malloc (size_t size) 
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      void *p = malloc (size);
+      if (p == NULL)
+        fail ("malloc (%zu) failed", size);
+      free (p);
+    }
+  return (rdtsc () - start) / ITER_CNT;
+}
+
+/* Returns the cycles per palloc_get_multiple() and
+   palloc_free_multiple() of PAGE_CNT pages. */
+static uint64_t
+time_palloc (size_t page_cnt) 
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      void *p = palloc_get_multiple (0, page_cnt);
+      if (p == NULL)
+        fail ("palloc_get_multiple (%zu) failed", page_cnt);
+      palloc_free_multiple (p, page_cnt);
+    }
+  return (rdtsc () - start) / ITER_CNT;
+}
@@ -0,0 +1,47 @@
+/* Allocates BLOCK_CNT blocks of each size from 1 byte to past
+   the largest size class, fills every block with its own byte
+   pattern, and checks that no block overwrote another before
+   freeing them.  Catches a size being mapped to a class whose
+   blocks are too small for it. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+/* Number of blocks of each size. */
+#define BLOCK_CNT 16
+
+/* Largest size tried; bigger than any size class. */
+#define MAX_SIZE 2100
+
+static uint8_t *blocks[BLOCK_CNT];
+
+void
+test_malloc_classes (void) 
+{
+  size_t size;
+  int i;
+
+  for (size = 1; size <= MAX_SIZE; size++) 
+    {
+      for (i = 0; i < BLOCK_CNT; i++) 
+        {
+          blocks[i] = malloc (size);
+          if (blocks[i] == NULL)
+            fail ("malloc (%zu) failed", size);
+          memset (blocks[i], i, size);
+        }
+      for (i = 0; i < BLOCK_CNT; i++) 
+        {
+          size_t j;
+
+          for (j = 0; j < size; j++)
+            if (blocks[i][j] != i)
+              fail ("block %d of size %zu was overwritten at byte %zu",
+                    i, size, j);
+          free (blocks[i]);
+        }
+    }
+  msg ("Checked sizes 1 through %d.", MAX_SIZE);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-classes) begin
+(malloc-classes) Checked sizes 1 through 2100.
+(malloc-classes) end
+EOF
+pass;
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Drop the timing lines, which depend on the machine.
+our ($test);
+my (@output) = grep (!/ cycles$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(malloc-magazine) begin
+(malloc-magazine) No block was overwritten.
+(malloc-magazine) end
+EOF
+pass;
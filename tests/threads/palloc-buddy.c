@@ -0,0 +1,81 @@
+/* Allocates kernel page blocks of every size from 1 to BLOCK_CNT
+   pages, fills each with its own byte, frees every other one,
+   allocates the same sizes again into the holes, and checks that
+   no block was handed out twice by verifying every byte.  Then
+   checks that, after everything is freed, a block as large as
+   all of them together can still be had. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Number of blocks; block I has I + 1 pages. */
+#define BLOCK_CNT 33
+
+static void *blocks[BLOCK_CNT];
+
+static void fill (int i);
+static void check (int i);
+
+void
+test_palloc_buddy (void) 
+{
+  size_t total = 0;
+  void *big;
+  int i;
+
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      blocks[i] = palloc_get_multiple (0, i + 1);
+      if (blocks[i] == NULL)
+        fail ("allocating %d pages failed", i + 1);
+      fill (i);
+      total += i + 1;
+    }
+  msg ("Allocated %d blocks.", BLOCK_CNT);
+
+  for (i = 0; i < BLOCK_CNT; i += 2) 
+    {
+      check (i);
+      palloc_free_multiple (blocks[i], i + 1);
+    }
+  for (i = 0; i < BLOCK_CNT; i += 2) 
+    {
+      blocks[i] = palloc_get_multiple (0, i + 1);
+      if (blocks[i] == NULL)
+        fail ("reallocating %d pages failed", i + 1);
+      fill (i);
+    }
+  for (i = 0; i < BLOCK_CNT; i++)
+    check (i);
+  msg ("Reallocated every other block.");
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    palloc_free_multiple (blocks[i], i + 1);
+  big = palloc_get_multiple (PAL_ZERO, total);
+  if (big == NULL)
+    fail ("allocating %zu pages after freeing failed", total);
+  palloc_free_multiple (big, total);
+  msg ("Freed all blocks.");
+}
+
+/* Fills block I with byte I + 1. */
+static void
+fill (int i) 
+{
+  memset (blocks[i], i + 1, (i + 1) * PGSIZE);
+}
+
+/* Checks that block I still holds byte I + 1 throughout. */
+static void
+check (int i) 
+{
+  const unsigned char *p = blocks[i];
+  size_t ofs;
+
+  for (ofs = 0; ofs < (size_t) (i + 1) * PGSIZE; ofs++)
+    if (p[ofs] != i + 1)
+      fail ("block %d overwritten at offset %zu", i, ofs);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) Allocated 33 blocks.
+(palloc-buddy) Reallocated every other block.
+(palloc-buddy) Freed all blocks.
+(palloc-buddy) end
+EOF
+pass;
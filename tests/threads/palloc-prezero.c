@@ -0,0 +1,63 @@
+/* Sleeps so that the idle thread can fill the kernel pool's
+   pre-zeroed list, then allocates PAGE_CNT zeroed pages, more
+   than the list holds, and checks that every one of them reads
+   as zeros.  Reports the cycles per palloc_get_page(PAL_ZERO)
+   for the first few pages, which should come pre-zeroed, and for
+   the last few, which the caller has to zero itself.  The pages
+   are dirtied before they are freed, so the idle thread has to
+   zero them again before reusing them. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+/* Number of pages allocated. */
+#define PAGE_CNT 256
+
+/* Number of pages timed at each end. */
+#define TIMED_CNT 16
+
+static uint64_t *pages[PAGE_CNT];
+
+void
+test_palloc_prezero (void) 
+{
+  uint64_t start, first = 0, last = 0;
+  int i;
+  size_t j;
+
+  for (i = 0; i < 2; i++) 
+    {
+      timer_sleep (10);
+
+      for (j = 0; j < PAGE_CNT; j++) 
+        {
+          start = rdtsc ();
+          pages[j] = palloc_get_page (PAL_ZERO);
+          if (j < TIMED_CNT)
+            first += rdtsc () - start;
+          else if (j >= PAGE_CNT - TIMED_CNT)
+            last += rdtsc () - start;
+          if (pages[j] == NULL)
+            fail ("palloc_get_page failed");
+        }
+
+      for (j = 0; j < PAGE_CNT; j++) 
+        {
+          size_t k;
+
+          for (k = 0; k < PGSIZE / sizeof *pages[j]; k++)
+            if (pages[j][k] != 0)
+              fail ("page %zu is not zeroed at word %zu", j, k);
+          pages[j][0] = pages[j][PGSIZE / sizeof *pages[j] - 1] = j + 1;
+          palloc_free_page (pages[j]);
+        }
+      msg ("Round %d: all pages were zeroed.", i + 1);
+    }
+
+  msg ("First pages: %llu cycles", first / (2 * TIMED_CNT));
+  msg ("Last pages: %llu cycles", last / (2 * TIMED_CNT));
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Drop the timing lines, which depend on the machine.
+our ($test);
+my (@output) = grep (!/ cycles$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(palloc-prezero) begin
+(palloc-prezero) Round 1: all pages were zeroed.
+(palloc-prezero) Round 2: all pages were zeroed.
+(palloc-prezero) end
+EOF
+pass;
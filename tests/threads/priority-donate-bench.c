@@ -0,0 +1,110 @@
+/* Has 64 threads of assorted priorities contend for 8 locks that
+   each of them acquires in nested order, starting from a
+   different lock depending on the thread, so that donation
+   chains up to 8 locks deep form and dissolve all the time.
+   Reports the time taken, and checks that the main thread's
+   donated priority is right while it holds every lock and that
+   it drops back once all the locks are released. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* Number of contending threads. */
+#define THREAD_CNT 64
+
+/* Number of nested locks. */
+#define LOCK_CNT 8
+
+/* Number of times each thread acquires its chain of locks. */
+#define ITER_CNT 50
+
+/* Information about the test. */
+struct bench
+  {
+    struct lock locks[LOCK_CNT];        /* Nested locks. */
+    struct semaphore done;              /* Upped once by each thread. */
+  };
+
+/* Information about an individual thread. */
+struct bench_thread
+  {
+    struct bench *bench;                /* Info shared between all threads. */
+    int first;                          /* First lock in this thread's chain. */
+  };
+
+static thread_func contender;
+
+void
+test_priority_donate_bench (void) 
+{
+  static struct bench_thread threads[THREAD_CNT];
+  struct bench bench;
+  long long acquire_cnt = 0;
+  uint64_t start, cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  for (i = 0; i < LOCK_CNT; i++)
+    lock_init (&bench.locks[i]);
+  sema_init (&bench.done, 0);
+
+  /* Hold every lock while the threads start, so that each one
+     that gets to run blocks on us and donates. */
+  for (i = 0; i < LOCK_CNT; i++)
+    lock_acquire (&bench.locks[i]);
+
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      struct bench_thread *t = &threads[i];
+      char name[16];
+
+      t->bench = &bench;
+      t->first = i % LOCK_CNT;
+      acquire_cnt += (long long) ITER_CNT * (LOCK_CNT - t->first);
+      snprintf (name, sizeof name, "contender %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i % (PRI_MAX - PRI_DEFAULT),
+                     contender, t);
+    }
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_MAX, thread_get_priority ());
+
+  start = rdtsc ();
+  for (i = LOCK_CNT - 1; i >= 0; i--)
+    lock_release (&bench.locks[i]);
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&bench.done);
+  cycles = rdtsc () - start;
+
+  msg ("%d threads acquired %lld locks in total.", THREAD_CNT, acquire_cnt);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+  msg ("Elapsed: %llu cycles", cycles);
+  msg ("Per lock_acquire(): %llu cycles", cycles / acquire_cnt);
+}
+
+static void
+contender (void *t_) 
+{
+  struct bench_thread *t = t_;
+  struct bench *bench = t->bench;
+  int i, l;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      for (l = t->first; l < LOCK_CNT; l++)
+        lock_acquire (&bench->locks[l]);
+      thread_yield ();
+      for (l = LOCK_CNT - 1; l >= t->first; l--)
+        lock_release (&bench->locks[l]);
+    }
+  sema_up (&bench->done);
+}
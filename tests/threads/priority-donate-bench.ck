@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Drop the timing lines, which differ from run to run.
+our ($test);
+my (@output) = grep (!/ cycles$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(priority-donate-bench) begin
+(priority-donate-bench) Main thread should have priority 63.  Actual priority: 63.
+(priority-donate-bench) 64 threads acquired 14400 locks in total.
+(priority-donate-bench) Main thread should have priority 31.  Actual priority: 31.
+(priority-donate-bench) end
+EOF
+pass;
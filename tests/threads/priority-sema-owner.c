@@ -0,0 +1,76 @@
+/* Low-priority thread L owns semaphore S, meaning that it is the
+   thread expected to up it, and blocks on another semaphore.
+   High-priority thread H then blocks on S, which should donate
+   H's priority to L even though L holds no lock.  Medium-priority
+   thread M then wakes L up: with the donation, L preempts M, ups
+   S, and drops back to its own priority.  Without it, M would run
+   to completion first. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct owner_test 
+  {
+    struct semaphore sema;              /* Owned by L, downed by H. */
+    struct semaphore go;                /* Downed by L, upped by M. */
+  };
+
+static thread_func l_thread_func;
+static thread_func m_thread_func;
+static thread_func h_thread_func;
+
+void
+test_priority_sema_owner (void) 
+{
+  struct owner_test ot;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  sema_init (&ot.sema, 0);
+  sema_init (&ot.go, 0);
+  thread_create ("low", PRI_DEFAULT + 1, l_thread_func, &ot);
+  thread_create ("high", PRI_DEFAULT + 3, h_thread_func, &ot);
+  thread_create ("med", PRI_DEFAULT + 2, m_thread_func, &ot);
+  msg ("Main thread finished.");
+}
+
+static void
+l_thread_func (void *ot_) 
+{
+  struct owner_test *ot = ot_;
+
+  sema_set_owner (&ot->sema, thread_current ());
+  msg ("Thread L owns the semaphore.");
+  sema_down (&ot->go);
+  msg ("Thread L woke up with priority %d.", thread_get_priority ());
+  sema_up (&ot->sema);
+  msg ("Thread L has priority %d after up.", thread_get_priority ());
+  msg ("Thread L finished.");
+}
+
+static void
+m_thread_func (void *ot_) 
+{
+  struct owner_test *ot = ot_;
+
+  msg ("Thread M ups L's semaphore.");
+  sema_up (&ot->go);
+  msg ("Thread M finished.");
+}
+
+static void
+h_thread_func (void *ot_) 
+{
+  struct owner_test *ot = ot_;
+
+  msg ("Thread H downs the owned semaphore.");
+  sema_down (&ot->sema);
+  msg ("Thread H finished.");
+}
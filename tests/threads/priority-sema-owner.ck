@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-sema-owner) begin
+(priority-sema-owner) Thread L owns the semaphore.
+(priority-sema-owner) Thread H downs the owned semaphore.
+(priority-sema-owner) Thread M ups L's semaphore.
+(priority-sema-owner) Thread L woke up with priority 34.
+(priority-sema-owner) Thread H finished.
+(priority-sema-owner) Thread M finished.
+(priority-sema-owner) Thread L has priority 32 after up.
+(priority-sema-owner) Thread L finished.
+(priority-sema-owner) Main thread finished.
+(priority-sema-owner) end
+EOF
+pass;
@@ -0,0 +1,77 @@
+/* The main thread takes a reader-writer lock shared.  A
+   higher-priority reader then takes it shared as well, without
+   waiting, and blocks on a semaphore.  A still-higher-priority
+   writer blocks acquiring the lock exclusively, which must
+   donate its priority to both readers.  When the main thread
+   releases its share, only the donation through the lock goes
+   away; the writer gets the lock as soon as the other reader
+   releases it too. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct rwlock_donate
+  {
+    struct rwlock rwlock;               /* Lock under test. */
+    struct semaphore go;                /* Lets the reader release. */
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_donate (void) 
+{
+  struct rwlock_donate rd;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rd.rwlock);
+  sema_init (&rd.go, 0);
+  rwlock_acquire_read (&rd.rwlock);
+
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &rd);
+  thread_create ("writer", PRI_DEFAULT + 10, writer_thread_func, &rd);
+  msg ("main: priority %d, expected %d.",
+       thread_get_priority (), PRI_DEFAULT + 10);
+
+  rwlock_release_read (&rd.rwlock);
+  msg ("main: priority %d, expected %d.",
+       thread_get_priority (), PRI_DEFAULT);
+
+  sema_up (&rd.go);
+  msg ("reader and writer must already have finished.");
+}
+
+static void
+reader_thread_func (void *rd_) 
+{
+  struct rwlock_donate *rd = rd_;
+
+  rwlock_acquire_read (&rd->rwlock);
+  msg ("reader: got the lock shared with main.");
+  sema_down (&rd->go);
+  msg ("reader: priority %d, expected %d.",
+       thread_get_priority (), PRI_DEFAULT + 10);
+  rwlock_release_read (&rd->rwlock);
+  msg ("reader: priority %d, expected %d.",
+       thread_get_priority (), PRI_DEFAULT + 1);
+}
+
+static void
+writer_thread_func (void *rd_) 
+{
+  struct rwlock_donate *rd = rd_;
+
+  msg ("writer: waiting for the lock.");
+  rwlock_acquire_write (&rd->rwlock);
+  msg ("writer: got the lock.");
+  rwlock_release_write (&rd->rwlock);
+}
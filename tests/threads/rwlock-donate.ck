@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) reader: got the lock shared with main.
+(rwlock-donate) writer: waiting for the lock.
+(rwlock-donate) main: priority 41, expected 41.
+(rwlock-donate) main: priority 31, expected 31.
+(rwlock-donate) reader: priority 41, expected 41.
+(rwlock-donate) writer: got the lock.
+(rwlock-donate) reader: priority 32, expected 32.
+(rwlock-donate) reader and writer must already have finished.
+(rwlock-donate) end
+EOF
+pass;
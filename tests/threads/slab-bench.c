@@ -0,0 +1,119 @@
+/* Allocates OBJ_CNT objects about the size of a struct inode
+   from an object cache and then from malloc(), frees them, and
+   reports the cycles per allocation and per free for each, along
+   with the number of pages each needed to hold the objects.  Also
+   checks that objects from a cache with a constructor keep their
+   constructed state across kmem_cache_free() and
+   kmem_cache_alloc(). */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Number of objects. */
+#define OBJ_CNT 256
+
+/* Object size; malloc() rounds it up to its size class. */
+#define OBJ_SIZE 600
+
+/* Set by the constructor. */
+#define OBJ_MAGIC 0x0b1ec7
+
+/* An object. */
+struct obj
+  {
+    int magic;                          /* OBJ_MAGIC once constructed. */
+    char data[OBJ_SIZE - sizeof (int)]; /* Filler. */
+  };
+
+static void *objs[OBJ_CNT];
+static int ctor_cnt;
+
+static void obj_ctor (void *);
+static size_t count_pages (void);
+
+void
+test_slab_bench (void) 
+{
+  struct kmem_cache *cache;
+  uint64_t start, slab_alloc, slab_free, malloc_alloc, malloc_free;
+  size_t slab_pages, malloc_pages;
+  int i;
+
+  cache = kmem_cache_create ("slab-bench", sizeof (struct obj), obj_ctor);
+  if (cache == NULL)
+    fail ("kmem_cache_create failed");
+
+  start = rdtsc ();
+  for (i = 0; i < OBJ_CNT; i++)
+    if ((objs[i] = kmem_cache_alloc (cache)) == NULL)
+      fail ("kmem_cache_alloc failed");
+  slab_alloc = rdtsc () - start;
+  slab_pages = count_pages ();
+  for (i = 0; i < OBJ_CNT; i++)
+    if (((struct obj *) objs[i])->magic != OBJ_MAGIC)
+      fail ("object %d was not constructed", i);
+  start = rdtsc ();
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (cache, objs[i]);
+  slab_free = rdtsc () - start;
+
+  /* Freed objects come back constructed, without calling the
+     constructor again. */
+  i = ctor_cnt;
+  objs[0] = kmem_cache_alloc (cache);
+  if (((struct obj *) objs[0])->magic != OBJ_MAGIC || ctor_cnt != i)
+    fail ("reused object lost its constructed state");
+  kmem_cache_free (cache, objs[0]);
+  kmem_cache_destroy (cache);
+  msg ("Constructed objects kept their state.");
+
+  start = rdtsc ();
+  for (i = 0; i < OBJ_CNT; i++)
+    if ((objs[i] = malloc (sizeof (struct obj))) == NULL)
+      fail ("malloc failed");
+  malloc_alloc = rdtsc () - start;
+  malloc_pages = count_pages ();
+  start = rdtsc ();
+  for (i = 0; i < OBJ_CNT; i++)
+    free (objs[i]);
+  malloc_free = rdtsc () - start;
+
+  msg ("Slab: %d objects in %zu pages", OBJ_CNT, slab_pages);
+  msg ("Malloc: %d objects in %zu pages", OBJ_CNT, malloc_pages);
+  msg ("Slab alloc: %llu cycles", slab_alloc / OBJ_CNT);
+  msg ("Slab free: %llu cycles", slab_free / OBJ_CNT);
+  msg ("Malloc alloc: %llu cycles", malloc_alloc / OBJ_CNT);
+  msg ("Malloc free: %llu cycles", malloc_free / OBJ_CNT);
+}
+
+static void
+obj_ctor (void *obj_) 
+{
+  struct obj *obj = obj_;
+
+  obj->magic = OBJ_MAGIC;
+  ctor_cnt++;
+}
+
+/* Returns the number of distinct pages that the objects in OBJS
+   start in. */
+static size_t
+count_pages (void) 
+{
+  size_t cnt = 0;
+  int i, j;
+
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      for (j = 0; j < i; j++)
+        if (pg_round_down (objs[j]) == pg_round_down (objs[i]))
+          break;
+      if (j == i)
+        cnt++;
+    }
+  return cnt;
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Drop the timing and page count lines, which depend on the build.
+our ($test);
+my (@output) = grep (!/ cycles$/ && !/ pages$/,
+		     read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(slab-bench) begin
+(slab-bench) Constructed objects kept their state.
+(slab-bench) end
+EOF
+pass;
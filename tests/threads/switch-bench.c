@@ -0,0 +1,99 @@
+/* Has two kernel threads of equal priority hand control back and
+   forth through a pair of semaphores, so that every sema_down()
+   blocks and every round trip takes exactly two context switches.
+   Runs once with every switch going through the full intr_frame
+   save and iretq, and once with the callee-saved-only fast path,
+   and reports the cycles per switch for each. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* Number of round trips in each run. */
+#define ITER_CNT 10000
+
+/* Information about one run. */
+struct pingpong
+  {
+    struct semaphore ping;              /* Upped by the pong thread. */
+    struct semaphore pong;              /* Upped by the ping thread. */
+    struct semaphore done;              /* Upped once by each thread. */
+    uint64_t cycles;                    /* Time taken by the ping thread. */
+  };
+
+static thread_func ping_thread;
+static thread_func pong_thread;
+static uint64_t run (bool fast);
+
+void
+test_switch_bench (void) 
+{
+  uint64_t full_cycles, fast_cycles;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  full_cycles = run (false);
+  msg ("%d round trips with full-frame switches done.", ITER_CNT);
+  fast_cycles = run (true);
+  msg ("%d round trips with fast switches done.", ITER_CNT);
+
+  msg ("Full-frame switch: %llu cycles", full_cycles / (2 * ITER_CNT));
+  msg ("Fast switch: %llu cycles", fast_cycles / (2 * ITER_CNT));
+}
+
+/* Runs ITER_CNT round trips with thread_fast_switch set to FAST
+   and returns the cycles they took. */
+static uint64_t
+run (bool fast) 
+{
+  struct pingpong pp;
+  bool old_fast = thread_fast_switch;
+
+  sema_init (&pp.ping, 0);
+  sema_init (&pp.pong, 0);
+  sema_init (&pp.done, 0);
+
+  thread_fast_switch = fast;
+  thread_create ("ping", PRI_DEFAULT, ping_thread, &pp);
+  thread_create ("pong", PRI_DEFAULT, pong_thread, &pp);
+  sema_down (&pp.done);
+  sema_down (&pp.done);
+  thread_fast_switch = old_fast;
+
+  return pp.cycles;
+}
+
+static void
+ping_thread (void *pp_) 
+{
+  struct pingpong *pp = pp_;
+  uint64_t start;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      sema_up (&pp->pong);
+      sema_down (&pp->ping);
+    }
+  pp->cycles = rdtsc () - start;
+  sema_up (&pp->done);
+}
+
+static void
+pong_thread (void *pp_) 
+{
+  struct pingpong *pp = pp_;
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      sema_down (&pp->pong);
+      sema_up (&pp->ping);
+    }
+  sema_up (&pp->done);
+}
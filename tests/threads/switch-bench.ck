@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Drop the timing lines, which differ from run to run.
+our ($test);
+my (@output) = grep (!/ cycles$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(switch-bench) begin
+(switch-bench) 10000 round trips with full-frame switches done.
+(switch-bench) 10000 round trips with fast switches done.
+(switch-bench) end
+EOF
+pass;
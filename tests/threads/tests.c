@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-stress", test_alarm_stress},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,10 +26,23 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-bench", test_priority_donate_bench},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"edf-basic", test_edf_basic},
+    {"switch-bench", test_switch_bench},
+    {"rwlock-donate", test_rwlock_donate},
+    {"waitqueue-bench", test_waitqueue_bench},
+    {"priority-sema-owner", test_priority_sema_owner},
+    {"palloc-buddy", test_palloc_buddy},
+    {"slab-bench", test_slab_bench},
+    {"malloc-classes", test_malloc_classes},
+    {"malloc-big", test_malloc_big},
+    {"malloc-magazine", test_malloc_magazine},
+    {"bitmap-bench", test_bitmap_bench},
+    {"palloc-prezero", test_palloc_prezero},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
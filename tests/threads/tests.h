@@ -11,6 +11,7 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_stress;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -19,10 +20,23 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_bench;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_edf_basic;
+extern test_func test_switch_bench;
+extern test_func test_rwlock_donate;
+extern test_func test_waitqueue_bench;
+extern test_func test_priority_sema_owner;
+extern test_func test_palloc_buddy;
+extern test_func test_slab_bench;
+extern test_func test_malloc_classes;
+extern test_func test_malloc_big;
+extern test_func test_malloc_magazine;
+extern test_func test_bitmap_bench;
+extern test_func test_palloc_prezero;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -0,0 +1,153 @@
+/* Blocks 1,000 threads of mixed priorities on a semaphore and
+   then on a condition variable, and reports the cycles that
+   sema_up() and cond_signal() take to wake the highest-priority
+   waiter.  The main thread runs at PRI_MAX while it signals, so
+   the woken threads do not run until every signal has been
+   timed.  Also checks that the waiters are woken in priority
+   order, oldest first among equals. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* Number of waiting threads. */
+#define WAITER_CNT 1000
+
+/* Waiter priorities cycle through this many values above
+   PRI_DEFAULT, all below PRI_MAX. */
+#define PRI_CNT (PRI_MAX - PRI_DEFAULT - 1)
+
+/* Shared state. */
+struct bench
+  {
+    struct semaphore sema;              /* Waited on in the first run. */
+    struct lock lock;                   /* Protects COND. */
+    struct condition cond;              /* Waited on in the second run. */
+    int order[WAITER_CNT];              /* Waiter numbers in wake order. */
+    int woken_cnt;                      /* Entries in ORDER. */
+  };
+
+/* One waiting thread. */
+struct waiter
+  {
+    struct bench *bench;                /* Shared state. */
+    int number;                         /* Creation order. */
+  };
+
+static struct bench bench;
+static struct waiter waiters[WAITER_CNT];
+
+static thread_func sema_waiter;
+static thread_func cond_waiter;
+static void spawn (struct bench *, thread_func *);
+static void check_order (struct bench *, const char *what);
+
+void
+test_waitqueue_bench (void) 
+{
+  struct bench *b = &bench;
+  uint64_t start, sema_cycles, cond_cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&b->sema, 0);
+  lock_init (&b->lock);
+  cond_init (&b->cond);
+
+  /* Each waiter outranks us, so it runs and blocks as soon as it
+     is created. */
+  spawn (b, sema_waiter);
+  thread_set_priority (PRI_MAX);
+  start = rdtsc ();
+  for (i = 0; i < WAITER_CNT; i++)
+    sema_up (&b->sema);
+  sema_cycles = rdtsc () - start;
+  thread_set_priority (PRI_DEFAULT);
+  check_order (b, "sema_up");
+
+  spawn (b, cond_waiter);
+  thread_set_priority (PRI_MAX);
+  lock_acquire (&b->lock);
+  start = rdtsc ();
+  for (i = 0; i < WAITER_CNT; i++)
+    cond_signal (&b->cond, &b->lock);
+  cond_cycles = rdtsc () - start;
+  lock_release (&b->lock);
+  thread_set_priority (PRI_DEFAULT);
+  check_order (b, "cond_signal");
+
+  msg ("sema_up with %d waiters: %llu cycles",
+       WAITER_CNT, sema_cycles / WAITER_CNT);
+  msg ("cond_signal with %d waiters: %llu cycles",
+       WAITER_CNT, cond_cycles / WAITER_CNT);
+}
+
+/* Creates WAITER_CNT threads running FUNC, waiter I at priority
+   PRI_DEFAULT + 1 + I % PRI_CNT. */
+static void
+spawn (struct bench *b, thread_func *func) 
+{
+  int i;
+
+  b->woken_cnt = 0;
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      waiters[i].bench = b;
+      waiters[i].number = i;
+      thread_create ("waiter", PRI_DEFAULT + 1 + i % PRI_CNT,
+                     func, &waiters[i]);
+    }
+}
+
+/* Checks that every waiter has run and that they were woken
+   highest priority first and in creation order within a
+   priority. */
+static void
+check_order (struct bench *b, const char *what) 
+{
+  int i;
+
+  if (b->woken_cnt != WAITER_CNT)
+    fail ("%s: only %d of %d waiters woke up",
+          what, b->woken_cnt, WAITER_CNT);
+  for (i = 1; i < WAITER_CNT; i++) 
+    {
+      int prev = b->order[i - 1], cur = b->order[i];
+
+      if (prev % PRI_CNT < cur % PRI_CNT
+          || (prev % PRI_CNT == cur % PRI_CNT && prev > cur))
+        fail ("%s: waiter %d woke up after waiter %d", what, prev, cur);
+    }
+  msg ("%s woke %d waiters in order.", what, WAITER_CNT);
+}
+
+static void
+sema_waiter (void *w_) 
+{
+  struct waiter *w = w_;
+  struct bench *b = w->bench;
+  enum intr_level old_level;
+
+  sema_down (&b->sema);
+  old_level = intr_disable ();
+  b->order[b->woken_cnt++] = w->number;
+  intr_set_level (old_level);
+}
+
+static void
+cond_waiter (void *w_) 
+{
+  struct waiter *w = w_;
+  struct bench *b = w->bench;
+
+  lock_acquire (&b->lock);
+  cond_wait (&b->cond, &b->lock);
+  b->order[b->woken_cnt++] = w->number;
+  lock_release (&b->lock);
+}
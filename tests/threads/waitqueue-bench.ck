@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Drop the timing lines, which differ from run to run.
+our ($test);
+my (@output) = grep (!/ cycles$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(waitqueue-bench) begin
+(waitqueue-bench) sema_up woke 1000 waiters in order.
+(waitqueue-bench) cond_signal woke 1000 waiters in order.
+(waitqueue-bench) end
+EOF
+pass;
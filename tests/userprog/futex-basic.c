@@ -0,0 +1,48 @@
+/* Checks futex_wait()'s early return when the word does not
+   hold the expected value and its timeout, that futex_wake()
+   wakes nobody when nobody waits, and that the user-space mutex,
+   condition variable and semaphore work when uncontended. */
+
+#include <synch.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct mutex m;
+  struct condvar c;
+  struct semaphore s;
+  int word = 5;
+
+  CHECK (futex_wait (&word, 4, 0) == FUTEX_AGAIN,
+         "futex_wait on a changed word returns at once");
+  CHECK (futex_wait (&word, 5, 2) == FUTEX_TIMEDOUT,
+         "futex_wait times out");
+  CHECK (futex_wake (&word, 1) == 0, "futex_wake with no waiters");
+
+  mutex_init (&m);
+  mutex_lock (&m);
+  CHECK (!mutex_trylock (&m), "mutex_trylock on a held mutex fails");
+  mutex_unlock (&m);
+  CHECK (mutex_trylock (&m), "mutex_trylock on a free mutex succeeds");
+  mutex_unlock (&m);
+  if (m.state != 0)
+    fail ("mutex state %d after unlock, expected 0", m.state);
+
+  condvar_init (&c);
+  mutex_lock (&m);
+  condvar_signal (&c);
+  condvar_broadcast (&c);
+  mutex_unlock (&m);
+  if (c.waiters != 0)
+    fail ("condvar reports %d waiters, expected 0", c.waiters);
+
+  sema_init (&s, 2);
+  sema_down (&s);
+  sema_down (&s);
+  CHECK (!sema_try_down (&s), "sema_try_down on a zero semaphore fails");
+  sema_up (&s);
+  CHECK (sema_try_down (&s), "sema_try_down after sema_up succeeds");
+}
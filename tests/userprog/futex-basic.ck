@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-basic) begin
+(futex-basic) futex_wait on a changed word returns at once
+(futex-basic) futex_wait times out
+(futex-basic) futex_wake with no waiters
+(futex-basic) mutex_trylock on a held mutex fails
+(futex-basic) mutex_trylock on a free mutex succeeds
+(futex-basic) sema_try_down on a zero semaphore fails
+(futex-basic) sema_try_down after sema_up succeeds
+(futex-basic) end
+futex-basic: exit(0)
+EOF
+pass;
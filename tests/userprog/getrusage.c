@@ -0,0 +1,33 @@
+/* Checks that getrusage() reports CPU time that grows while the
+   process computes, and blocked time and a voluntary context
+   switch after waiting for a child. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct rusage before, after;
+  volatile int spin;
+  int pid;
+
+  CHECK (getrusage (&before) == 0, "getrusage");
+  for (spin = 0; spin < 1000000; spin++)
+    continue;
+  CHECK (getrusage (&after) == 0, "getrusage");
+  if (after.cpu_cycles <= before.cpu_cycles)
+    fail ("CPU time did not grow while computing");
+
+  if ((pid = fork ("child-simple")) == 0)
+    exec ("child-simple");
+  msg ("wait(exec()) = %d", wait (pid));
+
+  before = after;
+  CHECK (getrusage (&after) == 0, "getrusage");
+  if (after.blocked_cycles <= before.blocked_cycles)
+    fail ("blocked time did not grow while waiting");
+  if (after.voluntary_switches <= before.voluntary_switches)
+    fail ("no voluntary switch counted while waiting");
+}
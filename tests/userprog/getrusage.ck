@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(getrusage) begin
+(getrusage) getrusage
+(getrusage) getrusage
+(child-simple) run
+child-simple: exit(81)
+(getrusage) wait(exec()) = 81
+(getrusage) getrusage
+(getrusage) end
+getrusage: exit(0)
+EOF
+pass;
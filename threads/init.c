@@ -20,8 +20,10 @@
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -85,6 +87,7 @@ int main(void) {
     /* Initialize memory system. */
     mem_end = palloc_init();
     malloc_init();
+    kmem_init();
     paging_init(mem_end);
 
 #ifdef USERPROG
@@ -105,6 +108,9 @@ int main(void) {
     thread_start();
     serial_init_queue();
     timer_calibrate();
+    if (timer_tickless)
+        timer_start_tickless();
+    trace_init();
 
 #ifdef FILESYS
     /* Initialize file system. */
@@ -217,6 +223,18 @@ static char **parse_options(char **argv) {
             random_init(atoi(value));
         else if (!strcmp(name, "-mlfqs"))
             thread_mlfqs = true;
+        else if (!strcmp(name, "-tickless"))
+            timer_tickless = true;
+        else if (!strcmp(name, "-trace"))
+            trace_enabled = true;
+        else if (!strcmp(name, "-latency"))
+            intr_latency = true;
+        else if (!strcmp(name, "-lockstat"))
+            lock_profiling = true;
+        else if (!strcmp(name, "-leaks"))
+            malloc_leak_check = true;
+        else if (!strcmp(name, "-zp"))
+            palloc_zero_target = atoi(value);
 #ifdef USERPROG
         else if (!strcmp(name, "-ul"))
             user_page_limit = atoi(value);
@@ -314,6 +332,12 @@ static void usage(void) {
            "  -f                 Format file system disk during startup.\n"
            "  -rs=SEED           Set random number seed to SEED.\n"
            "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+           "  -tickless          Run the timer in one-shot mode when idle.\n"
+           "  -trace             Trace context switches and dump them at shutdown.\n"
+           "  -latency           Time interrupts-off sections and report them at shutdown.\n"
+           "  -lockstat          Collect lock contention statistics and report them at shutdown.\n"
+           "  -leaks             Record malloc() call sites and report unfreed blocks at shutdown.\n"
+           "  -zp=COUNT          Keep COUNT pre-zeroed pages per pool (default 64).\n"
 #ifdef USERPROG
            "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -329,6 +353,8 @@ void power_off(void) {
 #endif
 
     print_stats();
+    if (trace_enabled)
+        trace_dump();
 
     printf("Powering off...\n");
     outw(0x604, 0x2000); /* Poweroff command for qemu */
@@ -340,6 +366,12 @@ void power_off(void) {
 static void print_stats(void) {
     timer_print_stats();
     thread_print_stats();
+    thread_print_rusage();
+    intr_print_latency();
+    lock_print_stats();
+    palloc_print_stats();
+    malloc_print_stats();
+    kmem_print_stats();
 #ifdef FILESYS
     disk_print_stats();
 #endif
@@ -110,6 +110,47 @@ static void pic_end_of_interrupt (int irq);
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 
+/* Interrupts-off latency tracing, enabled by the -latency
+   kernel command-line option.  Every stretch of time with
+   interrupts off is timed from the transition that turned them
+   off (intr_disable() or entry to an interrupt handler) to the
+   one that turned them back on (intr_enable() or return from the
+   handler).  Transitions made by other means, such as the "sti"
+   in the idle thread or the iretq that starts a new thread, are
+   not seen; the next off transition simply starts over.
+
+   This is how long an external interrupt, such as the timer's,
+   may be kept waiting. */
+bool intr_latency;
+
+/* Number of longest sections kept. */
+#define LATENCY_TOP 8
+
+/* Histogram buckets; bucket N counts sections of 2**N to
+   2**(N+1) - 1 cycles. */
+#define LATENCY_BUCKETS 48
+
+/* An interrupts-off section. */
+struct latency_section {
+	uint64_t cycles;            /* Length in TSC cycles. */
+	void *off_site;             /* Where interrupts were turned off. */
+	void *on_site;              /* Where they were turned on, or null
+	                               for an interrupt return. */
+};
+
+static bool latency_open;       /* Is a section being timed? */
+static uint64_t latency_start;  /* TSC when it started. */
+static void *latency_off_site;  /* Where it started. */
+static struct latency_section latency_top[LATENCY_TOP]; /* Longest first. */
+static long long latency_hist[LATENCY_BUCKETS];
+static long long latency_cnt;
+static uint64_t latency_total;
+
+static enum intr_level enable_from (void *caller);
+static enum intr_level disable_from (void *caller);
+static void latency_off (void *site);
+static void latency_on (void *site);
+
 /* Returns the current interrupt status. */
 enum intr_level
 intr_get_level (void) {
@@ -128,15 +169,33 @@ intr_get_level (void) {
    returns the previous interrupt status. */
 enum intr_level
 intr_set_level (enum intr_level level) {
-	return level == INTR_ON ? intr_enable () : intr_disable ();
+	void *caller = __builtin_return_address (0);
+
+	return level == INTR_ON ? enable_from (caller) : disable_from (caller);
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_enable (void) {
+	return enable_from (__builtin_return_address (0));
+}
+
+/* Disables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_disable (void) {
+	return disable_from (__builtin_return_address (0));
+}
+
+/* Enables interrupts on behalf of CALLER and returns the
+   previous interrupt status. */
+static enum intr_level
+enable_from (void *caller) {
 	enum intr_level old_level = intr_get_level ();
 	ASSERT (!intr_context ());
 
+	if (intr_latency && old_level == INTR_OFF)
+		latency_on (caller);
+
 	/* Enable interrupts by setting the interrupt flag.
 
 	   See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -146,9 +205,10 @@ intr_enable (void) {
 	return old_level;
 }
 
-/* Disables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_disable (void) {
+/* Disables interrupts on behalf of CALLER and returns the
+   previous interrupt status. */
+static enum intr_level
+disable_from (void *caller) {
 	enum intr_level old_level = intr_get_level ();
 
 	/* Disable interrupts by clearing the interrupt flag.
@@ -156,9 +216,92 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+	if (intr_latency && old_level == INTR_ON)
+		latency_off (caller);
+
 	return old_level;
 }
 
+/* Starts timing an interrupts-off section at SITE.  Interrupts
+   must be off. */
+static void
+latency_off (void *site) {
+	latency_open = true;
+	latency_start = rdtsc ();
+	latency_off_site = site;
+}
+
+/* Ends the interrupts-off section being timed, if any, at SITE
+   and records it.  Interrupts must be off. */
+static void
+latency_on (void *site) {
+	uint64_t cycles;
+	int bucket, i;
+
+	if (!latency_open)
+		return;
+	cycles = rdtsc () - latency_start;
+	latency_open = false;
+
+	latency_cnt++;
+	latency_total += cycles;
+	bucket = 63 - __builtin_clzll (cycles | 1);
+	latency_hist[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+
+	/* Insert into the longest-first list, dropping the shortest. */
+	if (cycles <= latency_top[LATENCY_TOP - 1].cycles)
+		return;
+	for (i = LATENCY_TOP - 1; i > 0 && latency_top[i - 1].cycles < cycles; i--)
+		latency_top[i] = latency_top[i - 1];
+	latency_top[i] = (struct latency_section) {
+		.cycles = cycles,
+		.off_site = latency_off_site,
+		.on_site = site,
+	};
+}
+
+/* Prints the interrupts-off latency statistics, if enabled. */
+void
+intr_print_latency (void) {
+	int i;
+
+	if (!intr_latency)
+		return;
+
+	/* Stop recording, so that printing does not disturb the
+	   numbers we are printing. */
+	intr_latency = false;
+
+	printf ("Interrupts off: %lld sections, %llu cycles average, "
+			"%llu cycles max\n",
+			latency_cnt, latency_cnt ? latency_total / latency_cnt : 0,
+			latency_top[0].cycles);
+
+	printf ("Longest sections (cycles, turned off at, turned on at):\n");
+	for (i = 0; i < LATENCY_TOP && latency_top[i].cycles > 0; i++) {
+		struct latency_section *l = &latency_top[i];
+		if (l->on_site != NULL)
+			printf ("%14llu %p %p\n", l->cycles, l->off_site, l->on_site);
+		else
+			printf ("%14llu %p (interrupt return)\n", l->cycles, l->off_site);
+	}
+
+	printf ("Section length histogram (cycles: sections):\n");
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+		if (latency_hist[i] > 0)
+			printf ("%14llu+ %lld\n", 1ULL << i, latency_hist[i]);
+
+	/* Same format as debug_backtrace(), so that the `backtrace'
+	   program can turn the sites into function names. */
+	printf ("Call stack:");
+	for (i = 0; i < LATENCY_TOP && latency_top[i].cycles > 0; i++) {
+		printf (" %p", latency_top[i].off_site);
+		if (latency_top[i].on_site != NULL)
+			printf (" %p", latency_top[i].on_site);
+	}
+	printf (".\n");
+}
+
 /* Initializes the interrupt system. */
 void
 intr_init (void) {
@@ -333,6 +476,14 @@ intr_handler (struct intr_frame *frame) {
 	bool external;
 	intr_handler_func *handler;
 
+	/* Interrupts were on in the interrupted code and an interrupt
+	   gate turned them off to run the handler, so a section starts.
+	   Trap gates (INTR_ON) leave them on, so there is none.  The
+	   handler function stands in for the call site. */
+	if (intr_latency && (frame->eflags & FLAG_IF)
+			&& intr_get_level () == INTR_OFF)
+		latency_off (intr_handlers[frame->vec_no]);
+
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
@@ -372,6 +523,11 @@ intr_handler (struct intr_frame *frame) {
 		if (yield_on_return)
 			thread_yield ();
 	}
+
+	/* The interrupt return will turn interrupts back on. */
+	if (intr_latency && (frame->eflags & FLAG_IF)
+			&& intr_get_level () == INTR_OFF)
+		latency_on (NULL);
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
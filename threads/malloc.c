@@ -5,17 +5,28 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
+   The size of each request, in bytes, is rounded up to the
+   nearest size class and assigned to the "descriptor" that
+   manages blocks of that size.  The descriptor keeps a list of
+   free blocks.  If the free list is nonempty, one of its blocks
+   is used to satisfy the request.
+
+   Blocks of the MAGAZINE_CLASSES smallest sizes go through a
+   per-thread "magazine" first: free() keeps up to MAGAZINE_SIZE
+   blocks of each size in the current thread's magazine, and
+   malloc() takes blocks from there, so neither needs the
+   descriptor's lock.  A thread refills an empty magazine from
+   the descriptor, and flushes a full one to it, MAGAZINE_BATCH
+   blocks at a time under a single acquisition of the lock, and
+   flushes everything when it exits.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
@@ -28,11 +39,39 @@
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
+   There are about four size classes per power of 2 (16, 24, 32,
+   40, ..., 128, 160, 192, 224, 264, 336, ...), each stretched so
+   that its blocks fill an arena with as little left over as
+   possible.  A 520-byte request, for example, gets a 576-byte
+   block, seven to an arena, rather than a 1 kB block.  A table
+   indexed by the request size in 8-byte units maps a request to
+   its descriptor in constant time.
+
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   descriptor.  We handle those by giving each one a "run" of
+   contiguous pages and sticking the allocation size at the
+   beginning of the run's arena header.
+
+   Runs are carved out of "spans" of at least SPAN_PAGES pages
+   obtained from the page allocator.  The header of every run
+   records whether it is the first or last run of its span and
+   whether the run before it is free, and a free run also keeps
+   its length in its last word, so freeing a run can merge it
+   with free neighbors in constant time.  Free runs sit on
+   free lists segregated by length.  A span that becomes
+   entirely free goes back to the page allocator only once more
+   than FREE_RUN_MAX pages are already sitting free; below that
+   it is kept for reuse, so most big allocations and frees never
+   reach the page allocator.
+
+   With the -leaks option, every block also gets a "leak record"
+   of its size and of the address malloc() was called from,
+   kept in a hash table keyed on the block's address until the
+   block is freed.  At shutdown, malloc_print_stats() lists the
+   blocks still outstanding grouped by call site; the addresses
+   can be turned into function names with the backtrace
+   utility. */
 
 /* Descriptor. */
 struct desc {
@@ -40,6 +79,16 @@ struct desc {
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
 	struct lock lock;           /* Lock. */
+	struct lock_class lock_class; /* Contention statistics for LOCK. */
+	char name[16];              /* Name of LOCK, e.g. "malloc 64". */
+
+	/* Statistics, updated with interrupts off. */
+	unsigned long long allocs;  /* Number of blocks handed out. */
+	unsigned long long frees;   /* Number of blocks freed. */
+	unsigned long long peak;    /* Most blocks live at once. */
+	unsigned long long requested; /* Bytes requested by callers. */
+	unsigned long long wasted;  /* Bytes of padding up to block_size. */
+	size_t arena_cnt;           /* Number of arenas, protected by LOCK. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -48,34 +97,178 @@ struct desc {
 /* Arena. */
 struct arena {
 	unsigned magic;             /* Always set to ARENA_MAGIC. */
+	unsigned flags;             /* RUN_* flags, for big blocks only. */
 	struct desc *desc;          /* Owning descriptor, null for big block. */
 	size_t free_cnt;            /* Free blocks; pages in big block. */
 };
 
+/* Arena flags for runs. */
+#define RUN_FIRST 0x1           /* First run in its span. */
+#define RUN_LAST 0x2            /* Last run in its span. */
+#define RUN_FREE 0x4            /* On a free run list. */
+#define RUN_PREV_FREE 0x8       /* The run just before is free. */
+
+/* Free run.  Its length in pages is also stored in the last word
+   of its last page, so that the run after it can find it. */
+struct free_run {
+	struct arena arena;         /* Arena header. */
+	struct list_elem elem;      /* Element in free_runs[]. */
+};
+
+/* Minimum number of pages obtained from the page allocator at a
+   time for runs. */
+#define SPAN_PAGES 16
+
+/* Number of pages that may sit in free runs before entirely free
+   spans are given back to the page allocator. */
+#define FREE_RUN_MAX 64
+
+/* Number of free run lists.  List I holds runs of 2**I to
+   2**(I + 1) - 1 pages, except that the last list holds all
+   longer runs too. */
+#define FREE_RUN_LISTS 6
+
 /* Free block. */
 struct block {
-	struct list_elem free_elem; /* Free list element. */
+	union {
+		struct list_elem free_elem; /* Free list element. */
+		struct block *next;     /* Next block in a magazine. */
+	};
+};
+
+/* Magazines. */
+#define MAGAZINE_CLASSES 12     /* Smallest size classes that use them. */
+#define MAGAZINE_SIZE 16        /* Most blocks per size class. */
+#define MAGAZINE_BATCH 8        /* Blocks moved per refill or flush. */
+
+/* A thread's magazines: free blocks of each of the smallest size
+   classes kept for the thread's own malloc() calls, so they
+   don't need the descriptor's lock.  Allocated from a descriptor
+   on first use rather than embedded in struct thread, whose page
+   is shared with the kernel stack. */
+struct magazines {
+	struct block *blocks[MAGAZINE_CLASSES]; /* Blocks linked through next. */
+	uint8_t cnt[MAGAZINE_CLASSES];    /* Number of blocks of each class. */
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[32];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Index into descs[] of the smallest descriptor whose blocks hold
+   N * 8 bytes, for N * 8 up to the largest block size. */
+static uint8_t size_to_desc[PGSIZE / 16 + 1];
+
+/* Bytes available for blocks in an arena. */
+#define ARENA_SPACE (PGSIZE - sizeof (struct arena))
+
+/* Runs for big blocks. */
+static struct list free_runs[FREE_RUN_LISTS]; /* Free runs by length. */
+static struct lock run_lock;    /* Protects runs and spans. */
+static struct lock_class run_lock_class; /* Contention statistics. */
+static size_t free_run_pages;   /* Pages in free runs. */
+static size_t span_cnt;         /* Number of spans. */
+static size_t span_pages;       /* Pages in spans. */
+
+/* Big block statistics, protected by run_lock. */
+static unsigned long long big_allocs; /* Number of big blocks. */
+static unsigned long long big_requested; /* Bytes requested. */
+static unsigned long long big_wasted; /* Bytes of padding to a page. */
+static unsigned long long big_live; /* Big blocks not yet freed. */
+static size_t big_live_pages;   /* Pages in big blocks not yet freed. */
+static size_t big_peak_pages;   /* Most pages in big blocks at once. */
+
+/* -leaks: Record the call site of every allocation? */
+bool malloc_leak_check;
+
+/* Leak record for a block that has not been freed. */
+struct leak {
+	void *block;                /* The block. */
+	void *caller;               /* Return address of the malloc() call. */
+	size_t size;                /* Bytes requested. */
+	struct leak *next;          /* Next in hash bucket or on free list. */
+};
+
+/* Leak records, when -leaks is given. */
+#define LEAK_PAGES 64           /* Pages for buckets and records. */
+#define LEAK_BUCKETS 1024       /* Hash buckets. */
+#define LEAK_SITES 32           /* Call sites in the leak report. */
+static struct leak **leak_buckets; /* Hash table keyed on block. */
+static struct leak *leak_free;  /* Unused records. */
+static unsigned long long leak_untracked; /* Blocks with no record. */
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct block *desc_alloc (struct desc *);
+static void desc_free (struct desc *, struct block *);
+static struct magazines *magazines_get (void);
+static struct desc *magazines_desc (void);
+static struct block *magazine_alloc (struct desc *);
+static void magazine_free (struct desc *, struct block *);
+static void magazine_flush (struct magazines *, size_t idx, size_t cnt);
+static void *big_alloc (size_t size);
+static void big_free (struct arena *);
+static void *malloc_block (size_t size);
+static void leak_record (void *block, size_t size, void *caller);
+static void leak_forget (void *block);
+static void print_leaks (void);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
-	size_t block_size;
+	size_t size, step, blocks_per_arena, block_size, i;
+	struct desc *d;
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
+	/* Blocks that don't fit an arena at least twice are big
+	   blocks. */
+	for (size = 16; (blocks_per_arena = ARENA_SPACE / size) >= 2;
+			size += step) {
+		/* Four classes per power of 2, but at least 8 bytes apart
+		   to keep blocks aligned. */
+		step = ((size_t) 1 << (63 - __builtin_clzll (size))) / 4;
+		if (step < 8)
+			step = 8;
+
+		/* Stretch SIZE to the largest multiple of 8 that still
+		   fits as many blocks into an arena.  Neighboring sizes
+		   that stretch to the same class share a descriptor. */
+		block_size = ROUND_DOWN (ARENA_SPACE / blocks_per_arena, 8);
+		if (desc_cnt > 0 && descs[desc_cnt - 1].block_size == block_size)
+			continue;
+
+		d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
 		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+		d->blocks_per_arena = blocks_per_arena;
 		list_init (&d->free_list);
-		lock_init (&d->lock);
+		snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
+		lock_init_class (&d->lock, &d->lock_class, d->name);
+	}
+
+	d = descs;
+	for (i = 0; i * 8 <= descs[desc_cnt - 1].block_size; i++) {
+		ASSERT (i < sizeof size_to_desc / sizeof *size_to_desc);
+		while (d->block_size < i * 8)
+			d++;
+		size_to_desc[i] = d - descs;
+	}
+	ASSERT (desc_cnt >= MAGAZINE_CLASSES);
+
+	for (i = 0; i < FREE_RUN_LISTS; i++)
+		list_init (&free_runs[i]);
+	lock_init_class (&run_lock, &run_lock_class, "malloc big");
+
+	if (malloc_leak_check) {
+		struct leak *l;
+
+		/* Buckets come first, then as many records as fit. */
+		leak_buckets = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, LEAK_PAGES);
+		for (l = (struct leak *) (leak_buckets + LEAK_BUCKETS);
+				(uint8_t *) (l + 1) <= (uint8_t *) leak_buckets
+				+ LEAK_PAGES * PGSIZE; l++) {
+			l->next = leak_free;
+			leak_free = l;
+		}
 	}
 }
 
@@ -83,9 +276,16 @@ malloc_init (void) {
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) {
+	void *p = malloc_block (size);
+	leak_record (p, size, __builtin_return_address (0));
+	return p;
+}
+
+/* Does the work of malloc(). */
+static void *
+malloc_block (size_t size) {
 	struct desc *d;
 	struct block *b;
-	struct arena *a;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -93,26 +293,41 @@ malloc (size_t size) {
 
 	/* Find the smallest descriptor that satisfies a SIZE-byte
 	   request. */
-	for (d = descs; d < descs + desc_cnt; d++)
-		if (d->block_size >= size)
-			break;
-	if (d == descs + desc_cnt) {
-		/* SIZE is too big for any descriptor.
-		   Allocate enough pages to hold SIZE plus an arena. */
-		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-		a = palloc_get_multiple (0, page_cnt);
-		if (a == NULL)
-			return NULL;
+	if (size > descs[desc_cnt - 1].block_size) {
+		/* SIZE is too big for any descriptor. */
+		return big_alloc (size);
+	}
+	d = &descs[size_to_desc[DIV_ROUND_UP (size, 8)]];
+
+	if (d < descs + MAGAZINE_CLASSES)
+		b = magazine_alloc (d);
+	else {
+		lock_acquire (&d->lock);
+		b = desc_alloc (d);
+		lock_release (&d->lock);
+	}
 
-		/* Initialize the arena to indicate a big block of PAGE_CNT
-		   pages, and return it. */
-		a->magic = ARENA_MAGIC;
-		a->desc = NULL;
-		a->free_cnt = page_cnt;
-		return a + 1;
+	if (b != NULL) {
+		enum intr_level old_level = intr_disable ();
+		d->allocs++;
+		if (d->allocs - d->frees > d->peak)
+			d->peak = d->allocs - d->frees;
+		d->requested += size;
+		d->wasted += d->block_size - size;
+		intr_set_level (old_level);
 	}
+	return b;
+}
 
-	lock_acquire (&d->lock);
+/* Takes a block off D's free list, creating a new arena if the
+   list is empty, and returns it.  Returns a null pointer if
+   memory is not available.  D's lock must be held. */
+static struct block *
+desc_alloc (struct desc *d) {
+	struct block *b;
+	struct arena *a;
+
+	ASSERT (lock_held_by_current_thread (&d->lock));
 
 	/* If the free list is empty, create a new arena. */
 	if (list_empty (&d->free_list)) {
@@ -120,10 +335,9 @@ malloc (size_t size) {
 
 		/* Allocate a page. */
 		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
+		if (a == NULL)
 			return NULL;
-		}
+		d->arena_cnt++;
 
 		/* Initialize arena and add its blocks to the free list. */
 		a->magic = ARENA_MAGIC;
@@ -139,10 +353,164 @@ malloc (size_t size) {
 	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
 	a = block_to_arena (b);
 	a->free_cnt--;
-	lock_release (&d->lock);
 	return b;
 }
 
+/* Puts block B back on D's free list, giving its arena back to
+   the page allocator if it is now entirely unused.  D's lock
+   must be held. */
+static void
+desc_free (struct desc *d, struct block *b) {
+	struct arena *a = block_to_arena (b);
+
+	ASSERT (lock_held_by_current_thread (&d->lock));
+
+	/* Add block to free list. */
+	list_push_front (&d->free_list, &b->free_elem);
+
+	/* If the arena is now entirely unused, free it. */
+	if (++a->free_cnt >= d->blocks_per_arena) {
+		size_t i;
+
+		ASSERT (a->free_cnt == d->blocks_per_arena);
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_remove (&b->free_elem);
+		}
+		palloc_free_page (a);
+		d->arena_cnt--;
+	}
+}
+
+/* Returns the descriptor that the magazines themselves are
+   allocated from. */
+static struct desc *
+magazines_desc (void) {
+	return &descs[size_to_desc[DIV_ROUND_UP (sizeof (struct magazines), 8)]];
+}
+
+/* Returns the current thread's magazines, allocating them on
+   first use.  Returns a null pointer if memory is not available,
+   in which case the caller goes straight to the descriptor. */
+static struct magazines *
+magazines_get (void) {
+	struct thread *t = thread_current ();
+
+	if (t->magazines == NULL) {
+		struct desc *d = magazines_desc ();
+		struct magazines *m;
+
+		lock_acquire (&d->lock);
+		m = (struct magazines *) desc_alloc (d);
+		lock_release (&d->lock);
+		if (m == NULL)
+			return NULL;
+		memset (m, 0, sizeof *m);
+		t->magazines = m;
+	}
+	return t->magazines;
+}
+
+/* Takes a block of D's size from the current thread's magazine,
+   first refilling the magazine from D if it is empty.  Returns a
+   null pointer if memory is not available. */
+static struct block *
+magazine_alloc (struct desc *d) {
+	struct magazines *m = magazines_get ();
+	size_t idx = d - descs;
+	struct block *b;
+
+	ASSERT (!intr_context ());
+
+	if (m == NULL) {
+		lock_acquire (&d->lock);
+		b = desc_alloc (d);
+		lock_release (&d->lock);
+		return b;
+	}
+
+	if (m->cnt[idx] == 0) {
+		lock_acquire (&d->lock);
+		while (m->cnt[idx] < MAGAZINE_BATCH && (b = desc_alloc (d)) != NULL) {
+			b->next = m->blocks[idx];
+			m->blocks[idx] = b;
+			m->cnt[idx]++;
+		}
+		lock_release (&d->lock);
+		if (m->cnt[idx] == 0)
+			return NULL;
+	}
+
+	b = m->blocks[idx];
+	m->blocks[idx] = b->next;
+	m->cnt[idx]--;
+	return b;
+}
+
+/* Puts block B, of D's size, into the current thread's magazine,
+   flushing part of the magazine to D if it overflows. */
+static void
+magazine_free (struct desc *d, struct block *b) {
+	struct magazines *m = magazines_get ();
+	size_t idx = d - descs;
+
+	ASSERT (!intr_context ());
+
+	if (m == NULL) {
+		lock_acquire (&d->lock);
+		desc_free (d, b);
+		lock_release (&d->lock);
+		return;
+	}
+
+	b->next = m->blocks[idx];
+	m->blocks[idx] = b;
+	if (++m->cnt[idx] > MAGAZINE_SIZE)
+		magazine_flush (m, idx, MAGAZINE_BATCH);
+}
+
+/* Returns CNT blocks from size class IDX of magazine M to their
+   descriptor. */
+static void
+magazine_flush (struct magazines *m, size_t idx, size_t cnt) {
+	struct desc *d = &descs[idx];
+
+	ASSERT (cnt <= m->cnt[idx]);
+
+	lock_acquire (&d->lock);
+	for (; cnt > 0; cnt--) {
+		struct block *b = m->blocks[idx];
+		m->blocks[idx] = b->next;
+		m->cnt[idx]--;
+		desc_free (d, b);
+	}
+	lock_release (&d->lock);
+}
+
+/* Returns every block in the current thread's magazines to its
+   descriptor, then frees the magazines themselves.  Called when
+   the thread exits, after its last malloc() or free(). */
+void
+malloc_drain (void) {
+	struct thread *t = thread_current ();
+	struct magazines *m = t->magazines;
+	struct desc *d;
+	size_t idx;
+
+	if (m == NULL)
+		return;
+
+	for (idx = 0; idx < MAGAZINE_CLASSES; idx++)
+		if (m->cnt[idx] > 0)
+			magazine_flush (m, idx, m->cnt[idx]);
+
+	t->magazines = NULL;
+	d = magazines_desc ();
+	lock_acquire (&d->lock);
+	desc_free (d, (struct block *) m);
+	lock_release (&d->lock);
+}
+
 /* Allocates and return A times B bytes initialized to zeroes.
    Returns a null pointer if memory is not available. */
 void *
@@ -156,9 +524,10 @@ calloc (size_t a, size_t b) {
 		return NULL;
 
 	/* Allocate and zero memory. */
-	p = malloc (size);
+	p = malloc_block (size);
 	if (p != NULL)
 		memset (p, 0, size);
+	leak_record (p, size, __builtin_return_address (0));
 
 	return p;
 }
@@ -185,7 +554,8 @@ realloc (void *old_block, size_t new_size) {
 		free (old_block);
 		return NULL;
 	} else {
-		void *new_block = malloc (new_size);
+		void *new_block = malloc_block (new_size);
+		leak_record (new_block, new_size, __builtin_return_address (0));
 		if (old_block != NULL && new_block != NULL) {
 			size_t old_size = block_size (old_block);
 			size_t min_size = new_size < old_size ? new_size : old_size;
@@ -205,40 +575,344 @@ free (void *p) {
 		struct arena *a = block_to_arena (b);
 		struct desc *d = a->desc;
 
+		leak_forget (p);
 		if (d != NULL) {
 			/* It's a normal block.  We handle it here. */
+			enum intr_level old_level = intr_disable ();
+			d->frees++;
+			intr_set_level (old_level);
 
 #ifndef NDEBUG
 			/* Clear the block to help detect use-after-free bugs. */
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
+			if (d < descs + MAGAZINE_CLASSES)
+				magazine_free (d, b);
+			else {
+				lock_acquire (&d->lock);
+				desc_free (d, b);
+				lock_release (&d->lock);
+			}
+		} else {
+			/* It's a big block.  Free its run. */
+			big_free (a);
+		}
+	}
+}
+
+/* Prints, for each size class that has been used, how many
+   blocks it handed out and how many bytes were lost to rounding
+   requests up to its block size.  Takes no locks, since it may be
+   called while powering off after a kernel panic. */
+void
+malloc_print_stats (void) {
+	unsigned long long requested = 0, wasted = 0;
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++) {
+		unsigned long long live = d->allocs - d->frees;
+
+		if (d->allocs == 0)
+			continue;
+		printf ("Malloc %zu: %llu live (%llu bytes), peak %llu, %zu arenas, "
+				"%llu allocs, %llu bytes wasted\n",
+				d->block_size, live, live * d->block_size, d->peak,
+				d->arena_cnt, d->allocs, d->wasted);
+		requested += d->requested;
+		wasted += d->wasted;
+	}
+	printf ("Malloc small: %llu bytes requested, %llu bytes wasted (%llu%%)\n",
+			requested, wasted,
+			requested + wasted > 0 ? wasted * 100 / (requested + wasted) : 0);
+	printf ("Malloc big: %llu allocs, %llu bytes requested, "
+			"%llu bytes wasted (%llu%%)\n",
+			big_allocs, big_requested, big_wasted,
+			big_requested + big_wasted > 0
+			? big_wasted * 100 / (big_requested + big_wasted) : 0);
+	printf ("Malloc big: %llu live (%zu pages), peak %zu pages, "
+			"%zu spans of %zu pages, %zu pages in free runs\n",
+			big_live, big_live_pages, big_peak_pages,
+			span_cnt, span_pages, free_run_pages);
+	if (malloc_leak_check)
+		print_leaks ();
+}
 
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
+/* Returns the hash bucket for BLOCK's leak record. */
+static struct leak **
+leak_bucket (void *block) {
+	return &leak_buckets[((uintptr_t) block >> 4) % LEAK_BUCKETS];
+}
 
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
+/* Records that BLOCK, of SIZE bytes, was allocated by a call
+   that returns to CALLER, if -leaks was given. */
+static void
+leak_record (void *block, size_t size, void *caller) {
+	enum intr_level old_level;
+	struct leak *l;
+
+	if (!malloc_leak_check || block == NULL)
+		return;
+
+	old_level = intr_disable ();
+	l = leak_free;
+	if (l != NULL) {
+		struct leak **bucket = leak_bucket (block);
+
+		leak_free = l->next;
+		l->block = block;
+		l->caller = caller;
+		l->size = size;
+		l->next = *bucket;
+		*bucket = l;
+	} else
+		leak_untracked++;
+	intr_set_level (old_level);
+}
 
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
+/* Drops the leak record for BLOCK, if it has one. */
+static void
+leak_forget (void *block) {
+	enum intr_level old_level;
+	struct leak **lp;
+
+	if (!malloc_leak_check)
+		return;
+
+	old_level = intr_disable ();
+	for (lp = leak_bucket (block); *lp != NULL; lp = &(*lp)->next)
+		if ((*lp)->block == block) {
+			struct leak *l = *lp;
+			*lp = l->next;
+			l->next = leak_free;
+			leak_free = l;
+			break;
+		}
+	intr_set_level (old_level);
+}
+
+/* Prints the blocks that have leak records, grouped by call
+   site, largest total first.  Blocks from call sites beyond the
+   first LEAK_SITES found are counted together. */
+static void
+print_leaks (void) {
+	struct site {
+		void *caller;           /* Call site. */
+		size_t cnt;             /* Outstanding blocks. */
+		size_t bytes;           /* Bytes requested for them. */
+	} sites[LEAK_SITES + 1];
+	size_t site_cnt = 0, cnt = 0, bytes = 0, i;
+
+	/* SITES[LEAK_SITES] collects the call sites that don't fit. */
+	sites[LEAK_SITES].cnt = sites[LEAK_SITES].bytes = 0;
+	for (i = 0; i < LEAK_BUCKETS; i++) {
+		struct leak *l;
+
+		for (l = leak_buckets[i]; l != NULL; l = l->next) {
+			size_t j;
+
+			for (j = 0; j < site_cnt; j++)
+				if (sites[j].caller == l->caller)
+					break;
+			if (j == site_cnt && site_cnt < LEAK_SITES) {
+				sites[j].caller = l->caller;
+				sites[j].cnt = sites[j].bytes = 0;
+				site_cnt++;
 			}
+			sites[j].cnt++;
+			sites[j].bytes += l->size;
+			cnt++;
+			bytes += l->size;
+		}
+	}
 
-			lock_release (&d->lock);
-		} else {
-			/* It's a big block.  Free its pages. */
-			palloc_free_multiple (a, a->free_cnt);
-			return;
+	printf ("Malloc leaks: %zu blocks, %zu bytes outstanding, "
+			"%llu allocations not tracked\n", cnt, bytes, leak_untracked);
+	if (sites[LEAK_SITES].cnt > 0)
+		printf ("  other call sites: %zu blocks, %zu bytes\n",
+				sites[LEAK_SITES].cnt, sites[LEAK_SITES].bytes);
+	while (site_cnt > 0) {
+		size_t max = 0;
+
+		for (i = 1; i < site_cnt; i++)
+			if (sites[i].bytes > sites[max].bytes)
+				max = i;
+		printf ("  %p: %zu blocks, %zu bytes\n",
+				sites[max].caller, sites[max].cnt, sites[max].bytes);
+		sites[max] = sites[--site_cnt];
+	}
+}
+
+/* Returns the index into free_runs[] for a run of PAGE_CNT
+   pages. */
+static size_t
+free_run_list (size_t page_cnt) {
+	size_t i = 63 - __builtin_clzll (page_cnt);
+	return i < FREE_RUN_LISTS ? i : FREE_RUN_LISTS - 1;
+}
+
+/* Returns the run that follows run A in its span, which must
+   not be the last one. */
+static struct arena *
+run_next (struct arena *a) {
+	ASSERT (!(a->flags & RUN_LAST));
+	return (struct arena *) ((uint8_t *) a + a->free_cnt * PGSIZE);
+}
+
+/* Makes the PAGE_CNT pages at A a free run with the RUN_FIRST and
+   RUN_LAST bits of FLAGS and puts it on its free list.  The run
+   before A must not be free. */
+static void
+run_make_free (struct arena *a, size_t page_cnt, unsigned flags) {
+	struct free_run *r = (struct free_run *) a;
+
+	ASSERT (lock_held_by_current_thread (&run_lock));
+
+	a->magic = ARENA_MAGIC;
+	a->flags = (flags & (RUN_FIRST | RUN_LAST)) | RUN_FREE;
+	a->desc = NULL;
+	a->free_cnt = page_cnt;
+	((size_t *) ((uint8_t *) a + page_cnt * PGSIZE))[-1] = page_cnt;
+	list_push_front (&free_runs[free_run_list (page_cnt)], &r->elem);
+	free_run_pages += page_cnt;
+
+	if (!(a->flags & RUN_LAST))
+		run_next (a)->flags |= RUN_PREV_FREE;
+}
+
+/* Takes free run A off its free list. */
+static void
+run_take (struct arena *a) {
+	struct free_run *r = (struct free_run *) a;
+
+	ASSERT (lock_held_by_current_thread (&run_lock));
+	ASSERT (a->magic == ARENA_MAGIC);
+	ASSERT (a->flags & RUN_FREE);
+
+	list_remove (&r->elem);
+	free_run_pages -= a->free_cnt;
+	a->flags &= ~RUN_FREE;
+
+	if (!(a->flags & RUN_LAST))
+		run_next (a)->flags &= ~RUN_PREV_FREE;
+}
+
+/* Returns a free run of at least PAGE_CNT pages, or a null
+   pointer if there is none. */
+static struct arena *
+run_find (size_t page_cnt) {
+	size_t i;
+
+	/* The first list that can hold a long enough run may also
+	   hold shorter ones, but every run on the lists after it is
+	   long enough. */
+	for (i = free_run_list (page_cnt); i < FREE_RUN_LISTS; i++) {
+		struct list_elem *e;
+
+		for (e = list_begin (&free_runs[i]); e != list_end (&free_runs[i]);
+				e = list_next (e)) {
+			struct free_run *r = list_entry (e, struct free_run, elem);
+			if (r->arena.free_cnt >= page_cnt)
+				return &r->arena;
 		}
 	}
+	return NULL;
 }
-
+
+/* Allocates a big block of SIZE bytes in a run of its own.
+   Returns a null pointer if memory is not available. */
+static void *
+big_alloc (size_t size) {
+	size_t page_cnt = DIV_ROUND_UP (size + sizeof (struct arena), PGSIZE);
+	struct arena *a;
+
+	lock_acquire (&run_lock);
+
+	/* If no free run is long enough, get a new span, falling back
+	   to one just long enough if a full-sized span isn't
+	   available. */
+	a = run_find (page_cnt);
+	if (a == NULL) {
+		size_t cnt = page_cnt > SPAN_PAGES ? page_cnt : SPAN_PAGES;
+
+		a = palloc_get_multiple (0, cnt);
+		if (a == NULL && cnt > page_cnt)
+			a = palloc_get_multiple (0, cnt = page_cnt);
+		if (a == NULL) {
+			lock_release (&run_lock);
+			return NULL;
+		}
+		span_cnt++;
+		span_pages += cnt;
+		run_make_free (a, cnt, RUN_FIRST | RUN_LAST);
+	}
+
+	/* Take the front of the run and free the rest. */
+	run_take (a);
+	if (a->free_cnt > page_cnt) {
+		run_make_free ((struct arena *) ((uint8_t *) a + page_cnt * PGSIZE),
+				a->free_cnt - page_cnt, a->flags & RUN_LAST);
+		a->flags &= ~RUN_LAST;
+		a->free_cnt = page_cnt;
+	}
+
+	big_allocs++;
+	big_requested += size;
+	big_wasted += page_cnt * PGSIZE - size;
+	big_live++;
+	big_live_pages += page_cnt;
+	if (big_live_pages > big_peak_pages)
+		big_peak_pages = big_live_pages;
+	lock_release (&run_lock);
+	return a + 1;
+}
+
+/* Frees the run of big block arena A, merging it with free runs
+   on either side. */
+static void
+big_free (struct arena *a) {
+	size_t page_cnt = a->free_cnt;
+	unsigned flags = a->flags;
+
+	ASSERT (!(flags & RUN_FREE));
+
+	lock_acquire (&run_lock);
+	big_live--;
+	big_live_pages -= page_cnt;
+
+	if (!(flags & RUN_LAST)) {
+		struct arena *next = run_next (a);
+		if (next->flags & RUN_FREE) {
+			run_take (next);
+			page_cnt += next->free_cnt;
+			flags = (flags & ~RUN_LAST) | (next->flags & RUN_LAST);
+		}
+	}
+	if (flags & RUN_PREV_FREE) {
+		size_t prev_cnt = ((size_t *) a)[-1];
+		struct arena *prev = (struct arena *) ((uint8_t *) a
+				- prev_cnt * PGSIZE);
+
+		ASSERT (prev->free_cnt == prev_cnt);
+		run_take (prev);
+		page_cnt += prev_cnt;
+		flags = (flags & ~RUN_FIRST) | (prev->flags & RUN_FIRST);
+		a = prev;
+	}
+
+	if ((flags & RUN_FIRST) && (flags & RUN_LAST)
+			&& free_run_pages + page_cnt > FREE_RUN_MAX) {
+		/* The whole span is free and we already have enough free
+		   pages on hand. */
+		span_cnt--;
+		span_pages -= page_cnt;
+		palloc_free_multiple (a, page_cnt);
+	} else
+		run_make_free (a, page_cnt, flags);
+
+	lock_release (&run_lock);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
@@ -1,8 +1,9 @@
 // clang-format off
 #include "threads/palloc.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 #include <bitmap.h>
 #include <debug.h>
@@ -29,13 +30,65 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2**ORDER pages, aligned to their size within the
+   pool, on one free list per order.  A request is rounded up to
+   the next order, taken from the smallest non-empty list at or
+   above it, split down as needed, and the unused tail pages are
+   freed again right away, so no memory is wasted on rounding.
+   A freed block is merged with its buddy for as long as the
+   buddy is free too.  Both take O(MAX_ORDER) list operations.
+
+   The free lists are linked through a per-page array kept next
+   to the pool's bitmap rather than through the free pages
+   themselves, so free memory is never written (much of it is
+   not yet mapped when palloc_init() runs).
+
+   Pages can be freed with interrupts off (the scheduler frees
+   dead threads' pages), so the free lists are protected by
+   turning interrupts off rather than by a lock.
+
+   When the CPU has nothing else to do, the idle thread calls
+   palloc_prezero() to take free pages out of each pool, zero
+   them, and keep them on a "pre-zeroed" list, up to
+   palloc_zero_target pages per pool.  A single-page PAL_ZERO
+   request is served from that list first, so it skips the
+   memset().  The list is linked through the same per-page links
+   as the free lists, which pages off the free lists don't use.
+   If a pool otherwise runs out of pages, its pre-zeroed pages
+   are given back to the buddy allocator before failing. */
+
+/* Largest block, in pages, is 2**MAX_ORDER. */
+#define MAX_ORDER 20
+
+/* End of a free list. */
+#define NO_BLOCK UINT32_MAX
+
+/* Free list links of the block headed by a page. */
+struct block_link {
+    uint32_t prev;           /* Previous block's page index, or NO_BLOCK. */
+    uint32_t next;           /* Next block's page index, or NO_BLOCK. */
+};
 
 /* A memory pool. */
 struct pool {
-    struct lock lock;        /* Mutual exclusion. */
+    const char *name;        /* Name for statistics. */
     struct bitmap *used_map; /* Bitmap of free pages. */
     uint8_t *base;           /* Base of pool. */
+    uint8_t *free_order;     /* Per page: 1 + order if it heads a free block, else 0. */
+    struct block_link *links; /* Per page: free list links, if it heads a free block. */
+    uint32_t free_lists[MAX_ORDER + 1];  /* First free block of each order. */
+    size_t free_blocks[MAX_ORDER + 1];   /* Length of each free list. */
+    size_t free_pages;       /* Total free pages. */
+    size_t peak_used;        /* Most pages ever in use at once. */
+    unsigned long long failed; /* Allocations that found no pages. */
+    uint32_t zeroed;         /* First pre-zeroed page, or NO_BLOCK. */
+    size_t zeroed_cnt;       /* Number of pre-zeroed pages. */
+    unsigned long long zeroed_total; /* Pages zeroed by palloc_prezero(). */
+    unsigned long long zero_hits; /* PAL_ZERO pages handed out pre-zeroed. */
+    unsigned long long zero_misses; /* PAL_ZERO pages zeroed by the caller. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -43,9 +96,17 @@ static struct pool kernel_pool, user_pool;
 
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
-static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end);
+
+/* Number of pre-zeroed pages to keep in each pool. */
+size_t palloc_zero_target = 64;
+static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end, const char *name);
 
 static bool page_from_pool(const struct pool *, void *page);
+static size_t buddy_alloc(struct pool *, int order);
+static void buddy_free_range(struct pool *, size_t page_idx, size_t page_cnt);
+static bool prezero_page(struct pool *);
+static void release_zeroed(struct pool *);
+static void print_pool_stats(const struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -159,7 +220,7 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
                     break;
                 }
                 // generate kernel pool
-                init_pool(&kernel_pool, &free_start, region_start, start + rem * PGSIZE);
+                init_pool(&kernel_pool, &free_start, region_start, start + rem * PGSIZE, "kernel pool");
                 // Transition to the next state
                 if (rem == size_in_pg) {
                     rem = user_pages;
@@ -188,7 +249,7 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
     }
 
     // generate the user pool
-    init_pool(&user_pool, &free_start, region_start, end);
+    init_pool(&user_pool, &free_start, region_start, end, "user pool");
 
     // Iterate over the e820_entry. Setup the usable.
     uint64_t usable_bound = (uint64_t)free_start;
@@ -222,11 +283,13 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
             if ((uint64_t)pool_end < end) {
                 page_cnt = ((uint64_t)pool_end - start) / PGSIZE;
                 bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+                buddy_free_range(pool, page_idx, page_cnt);
                 start = (uint64_t)pool_end;
                 goto split;
             } else {
                 page_cnt = ((uint64_t)end - start) / PGSIZE;
                 bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+                buddy_free_range(pool, page_idx, page_cnt);
             }
         }
     }
@@ -256,11 +319,49 @@ uint64_t palloc_init(void) {
    FLAGS, in which case the kernel panics. */
 void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
     struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-    lock_acquire(&pool->lock);
-    size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-    lock_release(&pool->lock);
+    size_t page_idx = BITMAP_ERROR;
+    bool zeroed = false;
     void *pages;
+    int order = 0;
+
+    /* Smallest order that holds PAGE_CNT pages. */
+    while (order <= MAX_ORDER && ((size_t)1 << order) < page_cnt)
+        order++;
+
+    if (page_cnt > 0) {
+        enum intr_level old_level = intr_disable();
+        if ((flags & PAL_ZERO) && page_cnt == 1 && pool->zeroed != NO_BLOCK) {
+            /* Take a pre-zeroed page, already marked in use. */
+            page_idx = pool->zeroed;
+            pool->zeroed = pool->links[page_idx].next;
+            pool->zeroed_cnt--;
+            zeroed = true;
+        } else if (order <= MAX_ORDER) {
+            page_idx = buddy_alloc(pool, order);
+            if (page_idx == BITMAP_ERROR && pool->zeroed != NO_BLOCK) {
+                release_zeroed(pool);
+                page_idx = buddy_alloc(pool, order);
+            }
+            if (page_idx != BITMAP_ERROR) {
+                /* Give back the pages past PAGE_CNT. */
+                buddy_free_range(pool, page_idx + page_cnt, ((size_t)1 << order) - page_cnt);
+                ASSERT(bitmap_none(pool->used_map, page_idx, page_cnt));
+                bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+            }
+        }
+
+        if (page_idx != BITMAP_ERROR) {
+            size_t used = bitmap_size(pool->used_map) - pool->free_pages - pool->zeroed_cnt;
+            if (used > pool->peak_used)
+                pool->peak_used = used;
+            if (zeroed)
+                pool->zero_hits++;
+            else if (flags & PAL_ZERO)
+                pool->zero_misses += page_cnt;
+        } else
+            pool->failed++;
+        intr_set_level(old_level);
+    }
 
     if (page_idx != BITMAP_ERROR)
         pages = pool->base + PGSIZE * page_idx;
@@ -268,7 +369,7 @@ void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
         pages = NULL;
 
     if (pages) {
-        if (flags & PAL_ZERO)
+        if ((flags & PAL_ZERO) && !zeroed)
             memset(pages, 0, PGSIZE * page_cnt);
     } else {
         if (flags & PAL_ASSERT)
@@ -308,29 +409,98 @@ void palloc_free_multiple(void *pages, size_t page_cnt) {
 #ifndef NDEBUG
     memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
+    enum intr_level old_level = intr_disable();
     ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
     bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+    buddy_free_range(pool, page_idx, page_cnt);
+    intr_set_level(old_level);
 }
 
 /* Frees the page at PAGE. */
 void palloc_free_page(void *page) { palloc_free_multiple(page, 1); }
 
-/* Initializes pool P as starting at START and ending at END */
-static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
+/* Zeroes one free page for the pre-zeroed list of the kernel
+   pool or, if that one is full, of the user pool.  Returns false
+   if both lists are full or have no free pages to take, true
+   otherwise.  Called by the idle thread. */
+bool palloc_prezero(void) { return prezero_page(&kernel_pool) || prezero_page(&user_pool); }
+
+/* Takes a free page out of POOL, zeroes it with interrupts on,
+   and puts it on POOL's pre-zeroed list.  Leaves at least
+   palloc_zero_target pages free for ordinary allocations.
+   Returns true if a page was zeroed. */
+static bool prezero_page(struct pool *pool) {
+    size_t page_idx = BITMAP_ERROR;
+    enum intr_level old_level;
+
+    old_level = intr_disable();
+    if (pool->zeroed_cnt < palloc_zero_target && pool->free_pages > palloc_zero_target) {
+        page_idx = buddy_alloc(pool, 0);
+        if (page_idx != BITMAP_ERROR)
+            bitmap_mark(pool->used_map, page_idx);
+    }
+    intr_set_level(old_level);
+    if (page_idx == BITMAP_ERROR)
+        return false;
+
+    memset(pool->base + PGSIZE * page_idx, 0, PGSIZE);
+
+    old_level = intr_disable();
+    pool->links[page_idx].next = pool->zeroed;
+    pool->zeroed = page_idx;
+    pool->zeroed_cnt++;
+    pool->zeroed_total++;
+    intr_set_level(old_level);
+    return true;
+}
+
+/* Gives all of POOL's pre-zeroed pages back to its free lists.
+   Interrupts must be off. */
+static void release_zeroed(struct pool *pool) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    while (pool->zeroed != NO_BLOCK) {
+        size_t page_idx = pool->zeroed;
+
+        pool->zeroed = pool->links[page_idx].next;
+        bitmap_reset(pool->used_map, page_idx);
+        buddy_free_range(pool, page_idx, 1);
+    }
+    pool->zeroed_cnt = 0;
+}
+
+/* Initializes pool P as starting at START and ending at END, naming its lock NAME */
+static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end, const char *name) {
     /* We'll put the pool's used_map at its base.
        Calculate the space needed for the bitmap
        and subtract it from the pool's size. */
     uint64_t pgcnt = (end - start) / PGSIZE;
     size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+    size_t links_bytes = DIV_ROUND_UP(pgcnt * sizeof(struct block_link), PGSIZE) * PGSIZE;
+    size_t order_bytes = DIV_ROUND_UP(pgcnt, PGSIZE) * PGSIZE;
+    int order;
+
+    ASSERT(pgcnt < NO_BLOCK);
 
-    lock_init(&p->lock);
+    p->name = name;
     p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
     p->base = (void *)start;
 
     // Mark all to unusable.
     bitmap_set_all(p->used_map, true);
 
-    *bm_base += bm_pages;
+    // The buddy allocator's per-page arrays follow the bitmap; no page heads a free block yet.
+    p->links = (struct block_link *)((uint8_t *)*bm_base + bm_pages);
+    p->free_order = (uint8_t *)*bm_base + bm_pages + links_bytes;
+    memset(p->free_order, 0, pgcnt);
+    for (order = 0; order <= MAX_ORDER; order++) {
+        p->free_lists[order] = NO_BLOCK;
+        p->free_blocks[order] = 0;
+    }
+    p->free_pages = 0;
+    p->zeroed = NO_BLOCK;
+
+    *bm_base += bm_pages + links_bytes + order_bytes;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -341,3 +511,146 @@ static bool page_from_pool(const struct pool *pool, void *page) {
     size_t end_page = start_page + bitmap_size(pool->used_map);
     return page_no >= start_page && page_no < end_page;
 }
+
+/* Adds the free block of 2**ORDER pages at PAGE_IDX to the
+   front of POOL's free list for ORDER. */
+static void block_push(struct pool *pool, size_t page_idx, int order) {
+    struct block_link *link = &pool->links[page_idx];
+
+    link->prev = NO_BLOCK;
+    link->next = pool->free_lists[order];
+    if (link->next != NO_BLOCK)
+        pool->links[link->next].prev = page_idx;
+    pool->free_lists[order] = page_idx;
+    pool->free_order[page_idx] = order + 1;
+    pool->free_blocks[order]++;
+}
+
+/* Removes the free block of 2**ORDER pages at PAGE_IDX from
+   POOL's free list for ORDER. */
+static void block_remove(struct pool *pool, size_t page_idx, int order) {
+    struct block_link *link = &pool->links[page_idx];
+
+    ASSERT(pool->free_order[page_idx] == order + 1);
+    if (link->prev != NO_BLOCK)
+        pool->links[link->prev].next = link->next;
+    else
+        pool->free_lists[order] = link->next;
+    if (link->next != NO_BLOCK)
+        pool->links[link->next].prev = link->prev;
+    pool->free_order[page_idx] = 0;
+    pool->free_blocks[order]--;
+}
+
+/* Removes a free block of 2**ORDER pages from POOL and returns
+   its page index, or BITMAP_ERROR if there is none.  Splits a
+   larger block if no block of ORDER is free.  Interrupts must be
+   off. */
+static size_t buddy_alloc(struct pool *pool, int order) {
+    size_t page_idx;
+    int i;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    for (i = order; i <= MAX_ORDER; i++)
+        if (pool->free_lists[i] != NO_BLOCK)
+            break;
+    if (i > MAX_ORDER)
+        return BITMAP_ERROR;
+
+    page_idx = pool->free_lists[i];
+    block_remove(pool, page_idx, i);
+
+    /* Put the upper half back until the block is the right size. */
+    while (i > order) {
+        i--;
+        block_push(pool, page_idx + ((size_t)1 << i), i);
+    }
+    pool->free_pages -= (size_t)1 << order;
+    return page_idx;
+}
+
+/* Adds the free block of 2**ORDER pages at PAGE_IDX to POOL,
+   merging it with its buddy for as long as the buddy is free. */
+static void buddy_free_block(struct pool *pool, size_t page_idx, int order) {
+    size_t pool_pages = bitmap_size(pool->used_map);
+
+    while (order < MAX_ORDER) {
+        size_t buddy = page_idx ^ ((size_t)1 << order);
+
+        if (buddy >= pool_pages || pool->free_order[buddy] != order + 1)
+            break;
+        block_remove(pool, buddy, order);
+        page_idx &= ~((size_t)1 << order);
+        order++;
+    }
+    block_push(pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages starting at PAGE_IDX in POOL, which
+   need not form a single block: the range is carved into the
+   largest aligned blocks it contains.  Interrupts must be off,
+   or the pool must not be in use yet. */
+static void buddy_free_range(struct pool *pool, size_t page_idx, size_t page_cnt) {
+    pool->free_pages += page_cnt;
+    while (page_cnt > 0) {
+        int order = page_idx != 0 ? __builtin_ctzll(page_idx) : MAX_ORDER;
+
+        if (order > MAX_ORDER)
+            order = MAX_ORDER;
+        while (((size_t)1 << order) > page_cnt)
+            order--;
+        buddy_free_block(pool, page_idx, order);
+        page_idx += (size_t)1 << order;
+        page_cnt -= (size_t)1 << order;
+    }
+}
+
+/* Prints free memory and fragmentation statistics for both
+   pools, then the hit rates of the thread and fd_table page
+   caches that sit in front of the kernel pool. */
+void palloc_print_stats(void) {
+    print_pool_stats(&kernel_pool);
+    print_pool_stats(&user_pool);
+    thread_print_page_caches();
+}
+
+/* Prints POOL's pages in use, their peak and the number of
+   failed allocations, then its free pages, its free blocks of
+   each order, and how fragmented the free memory is: the share
+   of free pages outside the largest free block. */
+static void print_pool_stats(const struct pool *pool) {
+    size_t blocks[MAX_ORDER + 1];
+    size_t free_pages, zeroed_cnt, peak_used, largest = 0;
+    unsigned long long failed, zeroed_total, zero_hits, zero_misses;
+    int order, top = 0;
+
+    enum intr_level old_level = intr_disable();
+    memcpy(blocks, pool->free_blocks, sizeof blocks);
+    free_pages = pool->free_pages;
+    zeroed_cnt = pool->zeroed_cnt;
+    peak_used = pool->peak_used;
+    failed = pool->failed;
+    zeroed_total = pool->zeroed_total;
+    zero_hits = pool->zero_hits;
+    zero_misses = pool->zero_misses;
+    intr_set_level(old_level);
+
+    printf("Palloc %s: %zu pages in use, peak %zu, %llu failed allocations\n", pool->name,
+           bitmap_size(pool->used_map) - free_pages - zeroed_cnt, peak_used, failed);
+    printf("Palloc %s: %llu pages zeroed while idle, %zu held pre-zeroed; "
+           "%llu PAL_ZERO pages served pre-zeroed, %llu zeroed by the caller\n",
+           pool->name, zeroed_total, zeroed_cnt, zero_hits, zero_misses);
+    for (order = 0; order <= MAX_ORDER; order++)
+        if (blocks[order] > 0) {
+            top = order;
+            largest = (size_t)1 << order;
+        }
+
+    printf("Palloc %s: %zu of %zu pages free, largest free block %zu pages, %zu%% fragmented\n", pool->name, free_pages,
+           bitmap_size(pool->used_map), largest, free_pages > 0 ? (free_pages - largest) * 100 / free_pages : 0);
+    printf("  free blocks by order:");
+    for (order = 0; order <= top; order++)
+        printf(" %d:%zu", order, blocks[order]);
+    printf("\n");
+}
@@ -0,0 +1,261 @@
+#include "threads/slab.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Slab allocator.
+   캐시마다 한 페이지짜리 slab들을 partial (일부 사용 중), full (전부 사용 중), empty (전부 비어있음) 세 리스트로 관리.
+   할당은 partial slab의 free 리스트에서 하나를 꺼내고 (O(1)), 없으면 empty slab을, 그것도 없으면 새 slab을 씀.
+   free된 오브젝트는 slab 안의 free 리스트로 돌아가고, 비게 된 slab은 SLAB_EMPTY_MAX개까지만 남기고 palloc에 반환.
+   free 리스트의 링크는 생성자가 없으면 오브젝트의 첫 word에, 있으면 오브젝트 뒤에 덧붙인 word에 저장 (초기화된 상태 보존). */
+
+/* slab의 magic 값 (잘못된 포인터 free 감지 목적) */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* 캐시마다 남겨두는 empty slab의 최대 수 (나머지는 palloc에 반환) */
+#define SLAB_EMPTY_MAX 1
+
+/* 오브젝트 캐시 */
+struct kmem_cache {
+    const char *name;             /* 출력용 이름. */
+    size_t obj_size;              /* 요청된 오브젝트 크기. */
+    size_t slot_size;             /* slab 안에서 오브젝트 하나가 차지하는 크기 (링크 포함, 8바이트 정렬). */
+    size_t link_ofs;              /* 슬롯 안에서 free 리스트 링크의 위치. */
+    size_t objs_per_slab;         /* slab 하나에 들어가는 오브젝트 수. */
+    kmem_ctor_func *ctor;         /* 생성자 (없으면 NULL). */
+    struct list partial;          /* 일부만 사용 중인 slab들. */
+    struct list full;             /* 전부 사용 중인 slab들. */
+    struct list empty;            /* 전부 비어있는 slab들 (최대 SLAB_EMPTY_MAX개). */
+    size_t empty_cnt;             /* empty 리스트의 길이. */
+    size_t in_use;                /* 할당된 오브젝트 수. */
+    size_t slab_cnt;              /* 보유 중인 slab 수. */
+    long long allocs;             /* kmem_cache_alloc() 호출 수. */
+    long long slabs_created;      /* 지금까지 만든 slab 수. */
+    struct lock lock;             /* 위 리스트들과 통계를 보호. */
+    struct lock_class lock_class; /* lock의 경합 통계 (-lockstat). */
+    struct list_elem elem;        /* kmem_caches의 elem. */
+};
+
+/* slab 헤더 (페이지의 시작 부분에 위치하고, 오브젝트들이 뒤따름) */
+struct slab {
+    unsigned magic;           /* 항상 SLAB_MAGIC. */
+    struct kmem_cache *cache; /* 소속 캐시. */
+    struct list_elem elem;    /* 캐시의 partial/full/empty 리스트 elem. */
+    void *free;               /* 첫번째 free 오브젝트 (없으면 NULL). */
+    size_t in_use;            /* 할당된 오브젝트 수. */
+};
+
+/* slab 안에서 첫 오브젝트의 위치 */
+#define SLAB_OBJ_OFS ROUND_UP(sizeof(struct slab), sizeof(void *))
+
+/* 생성된 모든 캐시 (통계 출력용) */
+static struct list kmem_caches;
+
+static struct slab *slab_create(struct kmem_cache *);
+static void slab_release(struct slab *);
+
+/* 오브젝트 OBJ의 free 리스트 링크 */
+static inline void **obj_link(const struct kmem_cache *cache, void *obj) { return (void **)((uint8_t *)obj + cache->link_ofs); }
+
+/* Slab allocator를 초기화 (malloc_init 이후, 캐시를 만들기 전에 호출) */
+void kmem_init(void) { list_init(&kmem_caches); }
+
+/* SIZE 바이트 오브젝트들의 캐시를 NAME으로 생성하는 함수 (CTOR은 없어도 됨).
+   오브젝트는 한 페이지의 slab에 최소 하나는 들어가야 함. 메모리가 없다면 NULL 반환. */
+struct kmem_cache *kmem_cache_create(const char *name, size_t size, kmem_ctor_func *ctor) {
+
+    ASSERT(name != NULL);
+    ASSERT(size > 0);
+
+    struct kmem_cache *cache = malloc(sizeof *cache);
+    if (cache == NULL)
+        return NULL;
+
+    cache->name = name;
+    cache->obj_size = size;
+    cache->ctor = ctor;
+    if (ctor != NULL) {
+        cache->link_ofs = ROUND_UP(size, sizeof(void *));
+        cache->slot_size = cache->link_ofs + sizeof(void *);
+    } else {
+        cache->link_ofs = 0;
+        cache->slot_size = ROUND_UP(size < sizeof(void *) ? sizeof(void *) : size, sizeof(void *));
+    }
+    cache->objs_per_slab = (PGSIZE - SLAB_OBJ_OFS) / cache->slot_size;
+    ASSERT(cache->objs_per_slab > 0);
+
+    list_init(&cache->partial);
+    list_init(&cache->full);
+    list_init(&cache->empty);
+    cache->empty_cnt = cache->in_use = cache->slab_cnt = 0;
+    cache->allocs = cache->slabs_created = 0;
+    lock_init_class(&cache->lock, &cache->lock_class, name);
+
+    enum intr_level old_level = intr_disable();
+    list_push_back(&kmem_caches, &cache->elem);
+    intr_set_level(old_level);
+
+    return cache;
+}
+
+/* CACHE와 slab들을 반환하는 함수 (할당된 오브젝트가 남아있으면 안됨) */
+void kmem_cache_destroy(struct kmem_cache *cache) {
+
+    ASSERT(cache != NULL);
+    ASSERT(cache->in_use == 0);
+
+    while (!list_empty(&cache->empty))
+        slab_release(list_entry(list_pop_front(&cache->empty), struct slab, elem));
+
+    enum intr_level old_level = intr_disable();
+    list_remove(&cache->elem);
+    intr_set_level(old_level);
+    free(cache);
+}
+
+/* CACHE에서 오브젝트 하나를 할당하는 함수 (생성자가 있다면 초기화된 상태).
+   메모리가 없다면 NULL 반환. */
+void *kmem_cache_alloc(struct kmem_cache *cache) {
+
+    struct slab *slab;
+    void *obj;
+
+    ASSERT(cache != NULL);
+
+    lock_acquire(&cache->lock);
+
+    /* partial slab이 없다면 empty slab을, 그것도 없다면 새 slab을 partial로 옮김 */
+    if (list_empty(&cache->partial)) {
+        if (!list_empty(&cache->empty)) {
+            list_push_front(&cache->partial, list_pop_front(&cache->empty));
+            cache->empty_cnt--;
+        } else {
+            /* 생성자를 부르는 동안 다른 스레드가 캐시를 쓸 수 있도록 락을 풀고 만듦 */
+            lock_release(&cache->lock);
+            slab = slab_create(cache);
+            if (slab == NULL)
+                return NULL;
+            lock_acquire(&cache->lock);
+            list_push_front(&cache->partial, &slab->elem);
+            cache->slab_cnt++;
+            cache->slabs_created++;
+        }
+    }
+
+    slab = list_entry(list_front(&cache->partial), struct slab, elem);
+    obj = slab->free;
+    slab->free = *obj_link(cache, obj);
+    if (++slab->in_use == cache->objs_per_slab) {
+        list_remove(&slab->elem);
+        list_push_front(&cache->full, &slab->elem);
+    }
+    cache->in_use++;
+    cache->allocs++;
+
+    lock_release(&cache->lock);
+    return obj;
+}
+
+/* CACHE에서 할당받은 오브젝트 OBJ를 반환하는 함수 (NULL은 무시).
+   생성자가 있는 캐시라면 OBJ는 생성자 직후의 상태로 돌아와 있어야 함. */
+void kmem_cache_free(struct kmem_cache *cache, void *obj) {
+
+    struct slab *slab, *victim = NULL;
+
+    if (obj == NULL)
+        return;
+
+    slab = pg_round_down(obj);
+    ASSERT(slab->magic == SLAB_MAGIC);
+    ASSERT(slab->cache == cache);
+    ASSERT(((uint8_t *)obj - (uint8_t *)slab - SLAB_OBJ_OFS) % cache->slot_size == 0);
+
+#ifndef NDEBUG
+    /* 생성자가 없다면 use-after-free 감지를 위해 내용을 지움 */
+    if (cache->ctor == NULL)
+        memset(obj, 0xcc, cache->obj_size);
+#endif
+
+    lock_acquire(&cache->lock);
+
+    *obj_link(cache, obj) = slab->free;
+    slab->free = obj;
+    if (slab->in_use-- == cache->objs_per_slab) {
+        list_remove(&slab->elem);
+        list_push_front(&cache->partial, &slab->elem);
+    }
+    if (slab->in_use == 0) {
+        list_remove(&slab->elem);
+        if (cache->empty_cnt < SLAB_EMPTY_MAX) {
+            list_push_front(&cache->empty, &slab->elem);
+            cache->empty_cnt++;
+        } else {
+            victim = slab;
+            cache->slab_cnt--;
+        }
+    }
+    cache->in_use--;
+
+    lock_release(&cache->lock);
+
+    if (victim != NULL)
+        slab_release(victim);
+}
+
+/* 모든 캐시의 사용량을 출력 (종료 시 print_stats에서 호출) */
+void kmem_print_stats(void) {
+
+    struct list_elem *e;
+
+    for (e = list_begin(&kmem_caches); e != list_end(&kmem_caches); e = list_next(e)) {
+        struct kmem_cache *c = list_entry(e, struct kmem_cache, elem);
+
+        if (c->allocs == 0)
+            continue;
+        printf("Slab %s: %zu-byte objects, %zu per slab, %zu in use in %zu slabs, %lld allocs, %lld slabs created\n", c->name,
+               c->obj_size, c->objs_per_slab, c->in_use, c->slab_cnt, c->allocs, c->slabs_created);
+    }
+}
+
+/* CACHE의 새 slab을 만들고 모든 오브젝트를 생성자로 초기화해서 free 리스트에 넣는 함수 (메모리가 없다면 NULL) */
+static struct slab *slab_create(struct kmem_cache *cache) {
+
+    struct slab *slab = palloc_get_page(0);
+    size_t i;
+
+    if (slab == NULL)
+        return NULL;
+
+    slab->magic = SLAB_MAGIC;
+    slab->cache = cache;
+    slab->free = NULL;
+    slab->in_use = 0;
+
+    /* 주소가 낮은 오브젝트부터 나가도록 거꾸로 넣음 */
+    for (i = cache->objs_per_slab; i-- > 0;) {
+        void *obj = (uint8_t *)slab + SLAB_OBJ_OFS + i * cache->slot_size;
+
+        if (cache->ctor != NULL)
+            cache->ctor(obj);
+        *obj_link(cache, obj) = slab->free;
+        slab->free = obj;
+    }
+    return slab;
+}
+
+/* 비어있는 SLAB의 페이지를 palloc에 반환 */
+static void slab_release(struct slab *slab) {
+
+    ASSERT(slab->in_use == 0);
+
+    slab->magic = 0;
+    palloc_free_page(slab);
+}
@@ -3,28 +3,149 @@
 #include "threads/synch.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "intrinsic.h"
 #include <stdio.h>
 #include <string.h>
 
 ////////////////////////////////////////////////////////////////////////////////
-//////////////////////////////// Semaphores ////////////////////////////////////
+/////////////////////////////// Wait Queues ////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-/* Sema_down & _up 에서 waiters 리스트 삽입에 활용되는 보조 함수 */
-bool priority_comparison(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED) {
-    struct thread *t_new = list_entry(new, struct thread, elem);
-    struct thread *t_existing = list_entry(existing, struct thread, elem);
+static void waitqueue_donate(struct waitqueue *);
+static void donate_onward(struct thread *);
+
+/* waitqueue 전용 비교 함수 ; 우선순위가 높은 스레드가 top, 같다면 먼저 들어온 (wait_seq가 작은) 스레드가 top.
+   wait_seq는 unsigned이니 한바퀴 돌아도 차이로 비교하면 됨 */
+static bool waiter_comparison(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+    struct thread *a = heap_entry(a_, struct thread, wait_elem);
+    struct thread *b = heap_entry(b_, struct thread, wait_elem);
+
+    if (a->priority != b->priority)
+        return a->priority > b->priority;
+    return (int)(a->wait_seq - b->wait_seq) < 0;
+}
+
+/* 빈 waitqueue로 초기화 */
+void waitqueue_init(struct waitqueue *wq) {
+    ASSERT(wq != NULL);
+
+    heap_init(&wq->waiters, waiter_comparison, NULL);
+    wq->next_seq = 0;
+    wq->owner = NULL;
+}
+
+/* 스레드 T를 WQ에 넣는 함수 (O(log n)) ; Interrupt가 꺼진 상태에서 호출하고, 보통 이어서 thread_block() */
+void waitqueue_push(struct waitqueue *wq, struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t->waitqueue == NULL);
+
+    t->waitqueue = wq;
+    t->wait_seq = wq->next_seq++;
+    heap_push(&wq->waiters, &t->wait_elem);
+    waitqueue_donate(wq);
+}
+
+/* WQ에서 우선순위가 가장 높은 스레드를 빼서 반환 (비어 있다면 NULL).
+   깨우는 것 (thread_unblock)은 호출자의 몫. */
+struct thread *waitqueue_pop(struct waitqueue *wq) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    struct heap_elem *top = heap_pop(&wq->waiters);
+    if (top == NULL)
+        return NULL;
 
-    return t_new->priority > t_existing->priority;
+    struct thread *t = heap_entry(top, struct thread, wait_elem);
+    t->waitqueue = NULL;
+    waitqueue_donate(wq); // 빠진 스레드가 주던 Donation 회수
+    return t;
+}
+
+/* 기다리는 동안 우선순위가 바뀐 스레드 T의 위치를 갱신 (O(log n)) ; thread_refresh_priority() 등이 호출 */
+void waitqueue_update(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t->waitqueue != NULL);
+
+    heap_update(&t->waitqueue->waiters, &t->wait_elem);
+    waitqueue_donate(t->waitqueue);
+}
+
+/* WQ에 기다리는 스레드가 없다면 true */
+bool waitqueue_empty(const struct waitqueue *wq) {
+    return heap_empty((struct heap *)&wq->waiters);
+}
+
+/* WQ를 기다리는 스레드들이 우선순위를 기부할 owner를 OWNER로 바꾸는 함수 (NULL이면 기부 중단).
+   WQ를 깨워줄 스레드가 정해진 경우 (완료 통보용 semaphore 등)에 쓰며, 이미 기다리는 스레드들의 Donation도 바로 옮겨감.
+   owner는 스레드가 종료될 때 (thread_exit) 자동으로 해제됨. */
+void waitqueue_set_owner(struct waitqueue *wq, struct thread *owner) {
+    ASSERT(wq != NULL);
+
+    enum intr_level old_level = intr_disable();
+    struct thread *old_owner = wq->owner;
+
+    if (old_owner != owner) {
+        if (old_owner != NULL) {
+            heap_remove(&old_owner->owned_queues, &wq->owner_elem);
+            wq->owner = NULL;
+            if (!thread_mlfqs) {
+                int old_priority = old_owner->priority;
+                thread_refresh_priority(old_owner);
+                if (old_owner->priority != old_priority)
+                    donate_onward(old_owner);
+            }
+        }
+        if (owner != NULL) {
+            wq->owner = owner;
+            heap_push(&owner->owned_queues, &wq->owner_elem);
+            waitqueue_donate(wq);
+        }
+    }
+    intr_set_level(old_level);
 }
 
+/* WQ를 기다리는 스레드들 중 가장 높은 우선순위를 반환 (대기자가 없다면 PRI_MIN - 1) */
+int waitqueue_donated_priority(const struct waitqueue *wq) {
+    struct heap_elem *top = heap_top((struct heap *)&wq->waiters);
+
+    return top != NULL ? heap_entry(top, struct thread, wait_elem)->priority : PRI_MIN - 1;
+}
+
+/* 스레드의 owned_queues heap 전용 비교 함수 ; 가장 높은 우선순위를 기부받는 waitqueue가 top에 위치 (max-heap) */
+bool owned_queue_comparison(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+    struct waitqueue *a = heap_entry(a_, struct waitqueue, owner_elem);
+    struct waitqueue *b = heap_entry(b_, struct waitqueue, owner_elem);
+
+    return waitqueue_donated_priority(a) > waitqueue_donated_priority(b);
+}
+
+/* WQ의 대기자가 바뀌었을 때 owner의 owned_queues 위치와 우선순위를 갱신하는 함수 (MLFQS에서는 Donation 없음).
+   owner가 다른 waitqueue를 기다리고 있다면 thread_refresh_priority() -> waitqueue_update()를 거쳐 이어서 전파되고,
+   락이나 rwlock을 기다리고 있다면 donate_onward()로 전파. */
+static void waitqueue_donate(struct waitqueue *wq) {
+    struct thread *owner = wq->owner;
+
+    if (owner == NULL || thread_mlfqs)
+        return;
+
+    int old_priority = owner->priority;
+    heap_update(&owner->owned_queues, &wq->owner_elem);
+    thread_refresh_priority(owner);
+    if (owner->priority != old_priority)
+        donate_onward(owner);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////// Semaphores ////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
 /* Semaphore 활용을 위해서 필요한 초기화 작업을 수행하는 함수 */
 void sema_init(struct semaphore *sema, unsigned value) {
 
     ASSERT(sema != NULL);
 
     sema->value = value; // unsigned (synch.h 참고)
-    list_init(&sema->waiters);
+    waitqueue_init(&sema->waiters);
 }
 
 /* Semaphore에 down/P 작업을 수행하는 함수. */
@@ -37,10 +158,9 @@ void sema_down(struct semaphore *sema) {
     enum intr_level old_level = intr_disable();
     struct thread *curr = thread_current();
 
-    /* value가 0일 경우 무한정 대기 */
+    /* value가 0일 경우 무한정 대기 ; 깨우는 쪽 (sema_up)이 waiters에서 빼주고 unblock */
     while (sema->value == 0) {
-        // list_push_back(&sema->waiters, &thread_current()->elem);
-        list_insert_ordered(&sema->waiters, &curr->elem, priority_comparison, NULL);
+        waitqueue_push(&sema->waiters, curr); // O(log n)
         thread_block();
     }
 
@@ -76,16 +196,25 @@ void sema_up(struct semaphore *sema) {
 
     enum intr_level old_level = intr_disable();
 
-    if (!list_empty(&sema->waiters)) {
-        list_sort(&sema->waiters, priority_comparison, NULL); // priority 가 큰 순서대로 정렬
-        thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
-    }
+    /* 우선순위가 가장 높은 대기자를 깨움 ; 기다리는 중에 바뀐 우선순위는 이미 waitqueue에 반영되어 있으니 정렬 불필요 */
+    struct thread *woken = waitqueue_pop(&sema->waiters);
+    if (woken != NULL)
+        thread_unblock(woken);
+    trace_record(TRACE_SEMA_UP, thread_current()->tid, woken != NULL ? woken->tid : 0, 0, 0, (uint32_t)(uintptr_t)sema);
 
     sema->value++;        // 대기중인 스레드가 있다면 : 여기서 sema_up으로 value를 1로 바꾸고, unblock된 waiter가 다시 값을 내리게 됨
-    thread_check_yield(); // 현재 thread의 priority와 ready_list의 priority를 비교하여 yield
+    thread_check_yield(); // 현재 thread의 priority와 ready_queue의 최고 priority를 비교하여 yield
     intr_set_level(old_level);
 }
 
+/* SEMA를 up 해줄 것으로 기대되는 스레드 OWNER를 지정하는 함수 (NULL이면 해제).
+   sema_down()으로 기다리는 스레드들이 OWNER에게 우선순위를 기부하니, 완료 통보용 semaphore의 Priority Inversion을 막음. */
+void sema_set_owner(struct semaphore *sema, struct thread *owner) {
+    ASSERT(sema != NULL);
+
+    waitqueue_set_owner(&sema->waiters, owner);
+}
+
 /* Semaphore를 위한 자체 테스트 기능 (디버깅 목적 ; sema를 '핑퐁' 하는 함수) */
 static void sema_test_helper(void *sema_) {
     struct semaphore *sema = sema_;
@@ -115,12 +244,40 @@ void sema_self_test(void) {
 ////////////////////////////////// Locks ///////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-/* Lock 관련 우선순위 donation 과정에서 donation list에 값을 넣기 위한 보조함수 */
-bool donate_priority_comparison(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED) {
-    struct thread *t_new = list_entry(new, struct thread, donation_elem);
-    struct thread *t_existing = list_entry(existing, struct thread, donation_elem);
+/* 락 경합 통계 수집 여부 (-lockstat) */
+bool lock_profiling;
+
+/* lock_init_class()로 등록된 class들 */
+static struct lock_class *lock_classes;
+
+/* 종료 시 출력할 class 수 */
+#define LOCK_STAT_TOP 12
+
+static void lock_take(struct lock *);
+static int donate_priority(struct lock *);
+static void rwlock_donate(struct rwlock *);
 
-    return t_new->priority > t_existing->priority;
+/* 락의 donors heap 전용 비교 함수 ; 우선순위가 높은 스레드가 top에 위치 (max-heap) */
+static bool donor_comparison(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+    struct thread *a = heap_entry(a_, struct thread, donor_elem);
+    struct thread *b = heap_entry(b_, struct thread, donor_elem);
+
+    return a->priority > b->priority;
+}
+
+/* 스레드의 held_locks heap 전용 비교 함수 ; 가장 높은 우선순위를 기부받는 락이 top에 위치 (max-heap) */
+bool held_lock_comparison(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+    struct lock *a = heap_entry(a_, struct lock, holder_elem);
+    struct lock *b = heap_entry(b_, struct lock, holder_elem);
+
+    return lock_donated_priority(a) > lock_donated_priority(b);
+}
+
+/* 락을 기다리는 스레드들 중 가장 높은 우선순위를 반환 (대기자가 없다면 PRI_MIN - 1) */
+int lock_donated_priority(const struct lock *lock) {
+    struct heap_elem *top = heap_top((struct heap *)&lock->donors);
+
+    return top != NULL ? heap_entry(top, struct thread, donor_elem)->priority : PRI_MIN - 1;
 }
 
 /* Lock을 초기화 하는 함수 (구현된 락은 반복적으로 확보될 수 없음 ; 단일 스레드 전용 락).
@@ -131,6 +288,26 @@ void lock_init(struct lock *lock) {
 
     lock->holder = NULL;
     sema_init(&lock->semaphore, 1);
+    heap_init(&lock->donors, donor_comparison, NULL);
+    lock->class = NULL;
+}
+
+/* LOCK을 초기화하고 경합 통계를 CLASS에 모으도록 연결하는 함수 (CLASS는 처음 쓰일 때 NAME으로 등록).
+   보통은 lock_init_named()로 호출하며, 락마다 따로 통계를 보고 싶다면 락 옆에 CLASS를 두고 직접 호출. */
+void lock_init_class(struct lock *lock, struct lock_class *class, const char *name) {
+    ASSERT(class != NULL);
+    ASSERT(name != NULL);
+
+    lock_init(lock);
+    lock->class = class;
+
+    enum intr_level old_level = intr_disable();
+    if (class->name == NULL) {
+        class->name = name;
+        class->next = lock_classes;
+        lock_classes = class;
+    }
+    intr_set_level(old_level);
 }
 
 /* Lock을 확보하는 함수 (확보 못하면 Blocked 상태로 전환, 필요시 우선순위 Donation).
@@ -144,27 +321,45 @@ void lock_acquire(struct lock *lock) {
     ASSERT(!intr_context());
     ASSERT(!lock_held_by_current_thread(lock));
 
-    /* Lock을 다른 스레드가 소유하고 있다면, */
-    if (lock->holder) {
+    struct thread *cur = thread_current();
+    enum intr_level old_level = intr_disable();
+    struct lock_class *class = lock_profiling ? lock->class : NULL;
+    bool contended = lock->holder != NULL;
+    uint64_t wait_start = class != NULL && contended ? rdtsc() : 0;
+
+    /* Lock을 다른 스레드가 소유하고 있다면 (MLFQS는 우선순위를 직접 계산하니 Donation 없음), */
+    if (lock->holder && !thread_mlfqs) {
 
-        /* 현재 스레드의 struct 멤버 값을 갱신 */
-        struct thread *cur = thread_current();
+        /* 락의 donors heap에 들어가서 락을 확보할 때까지 (새 소유자가 생겨도) 계속 우선순위를 기부 */
         cur->waiting_for_lock = lock;
+        heap_push(&lock->donors, &cur->donor_elem); // O(log n)
+        int depth = donate_priority(lock);
+
+        if (class != NULL && depth > 0) {
+            class->donations++;
+            if (depth > class->donation_depth_max)
+                class->donation_depth_max = depth;
+        }
+    }
 
-        /* 현재 스레드의 donation_elem을 lock 소유자의 donation 리스트에 삽입  */
-        list_insert_ordered(&lock->holder->donations, &cur->donation_elem, donate_priority_comparison, NULL);
+    sema_down(&lock->semaphore); // 락 홀더가 없다면 바로 성공, 아니라면 Block 상태로 진입
 
-        /* 반복문으로 꼬리물듯이 waiting_for_lock이 없을 때 까지 우선순위 donate (donation_elem은 내가 대기중인 스레드에만 제공) */
-        while (cur->waiting_for_lock) {
-            struct thread *holder = cur->waiting_for_lock->holder;
-            holder->priority = cur->priority;
-            cur = holder;
-        } /* 중요 : Donation 리스트는 사실상 해당 락을 기다리고 있는 스레드를 기록하는 역할 */
+    /* 기다린 시간을 누적 */
+    if (class != NULL && contended) {
+        uint64_t waited = rdtsc() - wait_start;
+        class->contended++;
+        class->wait_cycles += waited;
+        if (waited > class->wait_max)
+            class->wait_max = waited;
     }
 
-    sema_down(&lock->semaphore);               // 락 홀더가 없다면 바로 성공, 아니라면 Block 상태로 진입
-    thread_current()->waiting_for_lock = NULL; // 결국 sema_down을 성공했으니, 락을 acquire하는데 성공한 것
-    lock->holder = thread_current();
+    /* 결국 sema_down을 성공했으니, 락을 acquire하는데 성공한 것 ; 더 이상 donor가 아님 */
+    if (cur->waiting_for_lock) {
+        heap_remove(&lock->donors, &cur->donor_elem);
+        cur->waiting_for_lock = NULL;
+    }
+    lock_take(lock);
+    intr_set_level(old_level);
 }
 
 /* Lock acquire를 시도하되, 성공하면 true, 실패하면 False를 반환.
@@ -175,9 +370,11 @@ bool lock_try_acquire(struct lock *lock) {
     ASSERT(lock != NULL);
     ASSERT(!lock_held_by_current_thread(lock));
 
+    enum intr_level old_level = intr_disable();
     bool success = sema_try_down(&lock->semaphore); // sema_try_down() 실패시 'false', 성공시 'true'
     if (success)
-        lock->holder = thread_current();
+        lock_take(lock);
+    intr_set_level(old_level);
 
     return success;
 }
@@ -189,33 +386,80 @@ void lock_release(struct lock *lock) {
     ASSERT(lock_held_by_current_thread(lock));
 
     struct thread *cur = thread_current();
+    enum intr_level old_level = intr_disable();
 
-    /* lock을 기다리며 donation 리스트를 순회, 해당 락을 기다리던 모든 스레드의 donation_elem을 리스트에서 제거 */
-    struct list_elem *e;
-    for (e = list_begin(&cur->donations); e != list_end(&cur->donations); e = list_next(e)) {
-        struct thread *t = list_entry(e, struct thread, donation_elem);
-        if (t->waiting_for_lock == lock)
-            list_remove(&t->donation_elem);
+    /* 보유한 시간을 누적 (-lockstat이 도중에 켜진 경우는 acquired_at이 없으니 제외) */
+    if (lock_profiling && lock->class != NULL && lock->acquired_at != 0) {
+        uint64_t held = rdtsc() - lock->acquired_at;
+        lock->class->hold_cycles += held;
+        if (held > lock->class->hold_max)
+            lock->class->hold_max = held;
+        lock->acquired_at = 0;
     }
 
-    /* 현재 우선순위를 원래 우선순위로 원복 */
-    cur->priority = cur->priority_original;
+    /* 이 락으로 받던 Donation을 held_locks에서 제거하고 (O(log n)), 남은 락들 기준으로 우선순위 재계산 (O(1)).
+       이 락의 donors는 그대로 남아서 다음 소유자에게 기부하게 됨 */
+    lock->holder = NULL;
+    if (!thread_mlfqs) {
+        heap_remove(&cur->held_locks, &lock->holder_elem);
+        thread_refresh_priority(cur);
+    }
 
-    /* donation list가 여전히 내용물이 있다면, 다른 락을 들고 있다는 뜻 */
-    if (!list_empty(&cur->donations)) {
+    /* 릴리즈에 성공했으니 Semaphoare value도 올려줘야 함 */
+    sema_up(&lock->semaphore);
+    intr_set_level(old_level);
+}
+
+/* 현재 스레드를 락의 소유자로 등록하는 함수 (Interrupt가 꺼진 상태에서 호출).
+   아직 락을 기다리는 스레드들이 있다면 새 소유자인 현재 스레드가 Donation을 이어받음. */
+static void lock_take(struct lock *lock) {
 
-        /* 따라서 donation_list를 우선순위에 따라서 다시 한번 정렬해주고, */
-        list_sort(&cur->donations, donate_priority_comparison, NULL);
+    struct thread *cur = thread_current();
 
-        /* 제일 우선순위 높은 스레드를 찾은 뒤, 해당 스레드의 우선순위가 나보다 높다면 내가 우선순위를 승계 */
-        struct thread *front = list_entry(list_front(&cur->donations), struct thread, donation_elem);
-        if (front->priority > cur->priority)
-            cur->priority = front->priority;
+    lock->holder = cur;
+    if (!thread_mlfqs) {
+        heap_push(&cur->held_locks, &lock->holder_elem);
+        thread_refresh_priority(cur);
     }
 
-    /* 릴리즈에 성공했으니, 해당 락의 소유주 정보를 제거하고 Semaphoare value도 올려줘야 함 */
-    lock->holder = NULL;
-    sema_up(&lock->semaphore);
+    if (lock_profiling && lock->class != NULL) {
+        lock->class->acquires++;
+        lock->acquired_at = rdtsc();
+    }
+}
+
+/* LOCK의 donors가 바뀌었을 때 (새 donor 추가, donor의 우선순위 변경), 소유자를 따라 꼬리물듯이 Donation을 전파하는 함수.
+   단계마다 heap_update 두번 (O(log n))이면 되고, 소유자의 우선순위가 바뀌지 않는 단계에서 전파를 멈춤.
+   우선순위가 바뀐 소유자 수 (Chain 깊이)를 반환.
+   Interrupt가 꺼진 상태에서 호출해야 함. */
+static int donate_priority(struct lock *lock) {
+
+    struct thread *holder;
+    int depth = 0;
+
+    while ((holder = lock->holder) != NULL) {
+        int old_priority = holder->priority;
+
+        /* 소유자의 held_locks에서 이 락의 위치를 갱신하고, 소유자의 우선순위를 다시 계산 */
+        heap_update(&holder->held_locks, &lock->holder_elem);
+        thread_refresh_priority(holder);
+
+        /* 소유자의 우선순위가 그대로거나 소유자가 다른 락을 기다리지 않는다면 전파 종료 */
+        if (holder->priority == old_priority)
+            break;
+        depth++;
+        if (holder->waiting_for_rwlock != NULL) {
+            donate_onward(holder); // rwlock은 소유자가 여럿일 수 있으니 따로 처리
+            break;
+        }
+        if (holder->waiting_for_lock == NULL)
+            break;
+
+        /* 소유자 역시 대기 중인 donor이니, 그 락의 donors에서 위치를 갱신하고 다음 단계로 */
+        lock = holder->waiting_for_lock;
+        heap_update(&lock->donors, &holder->donor_elem);
+    }
+    return depth;
 }
 
 /* 현재 스레드가 해당 락의 소유주인지 확인하는 함수.
@@ -227,33 +471,254 @@ bool lock_held_by_current_thread(const struct lock *lock) {
     return lock->holder == thread_current();
 }
 
+/* 경합 통계를 기다린 시간 합계가 큰 class부터 출력 (-lockstat) */
+void lock_print_stats(void) {
+
+    struct lock_class *top[LOCK_STAT_TOP];
+    struct lock_class *c;
+    int cnt = 0, i;
+
+    if (!lock_profiling)
+        return;
+
+    /* 출력하는 동안 쓰이는 console lock 등이 숫자를 바꾸지 않도록 수집을 멈춤 */
+    lock_profiling = false;
+
+    for (c = lock_classes; c != NULL; c = c->next) {
+        if (c->acquires == 0)
+            continue;
+        if (cnt == LOCK_STAT_TOP && c->wait_cycles <= top[cnt - 1]->wait_cycles)
+            continue;
+        if (cnt < LOCK_STAT_TOP)
+            cnt++;
+        for (i = cnt - 1; i > 0 && top[i - 1]->wait_cycles < c->wait_cycles; i--)
+            top[i] = top[i - 1];
+        top[i] = c;
+    }
+
+    printf("Lock contention (Kcycles):  name             acquires contended  wait-sum  wait-max  hold-sum  hold-max donate depth\n");
+    for (i = 0; i < cnt; i++) {
+        c = top[i];
+        printf("%27s %-16s %9lld %9lld %9llu %9llu %9llu %9llu %6lld %5d\n", "", c->name, c->acquires, c->contended,
+               c->wait_cycles / 1000, c->wait_max / 1000, c->hold_cycles / 1000, c->hold_max / 1000, c->donations,
+               c->donation_depth_max);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
-///////////////////////////// Conditional Variables ////////////////////////////
+/////////////////////////////// Reader-Writer Locks ////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-/* List에 삽입 가능한 형태로 semaphore를 감싸주는 일종의 컨테이너 역할 (Wrapper). */
-struct semaphore_elem {
-    struct list_elem elem;      // 리스트에 넣기 위한 elem
-    struct semaphore semaphore; // 실제 semaphore
-};
+static struct rw_hold *rw_hold_find(struct thread *, const struct rwlock *);
+static void rwlock_wait(struct rwlock *, struct waitqueue *waiters);
+static void rwlock_wake(struct rwlock *);
 
-/* cond_wait() & signal()에서 리스트 삽입을 돕기 위한 보조 함수 */
-bool sema_priority_comparison(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) {
-    struct semaphore_elem *a = list_entry(a_, struct semaphore_elem, elem);
-    struct semaphore_elem *b = list_entry(b_, struct semaphore_elem, elem);
-    struct list *waiter_a_sema = &(a->semaphore.waiters);
-    struct list *waiter_b_sema = &(b->semaphore.waiters);
+/* rwlock을 초기화 하는 함수 */
+void rwlock_init(struct rwlock *rw) {
+    ASSERT(rw != NULL);
 
-    return list_entry(list_begin(waiter_a_sema), struct thread, elem)->priority > list_entry(list_begin(waiter_b_sema), struct thread, elem)->priority;
+    rw->writer = NULL;
+    list_init(&rw->readers);
+    waitqueue_init(&rw->read_waiters);
+    waitqueue_init(&rw->write_waiters);
+    rw->waiting_writers = 0;
+    heap_init(&rw->donors, donor_comparison, NULL);
 }
 
+/* rwlock을 공유 (읽기) 모드로 확보하는 함수.
+   배타 모드 소유자가 있거나 배타 모드를 기다리는 스레드가 있다면 (Writer preference) Block 상태로 대기.
+   같은 rwlock을 중복해서 확보할 수 없으며, Interrupt Handler에서 호출하면 안됨. */
+void rwlock_acquire_read(struct rwlock *rw) {
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+    ASSERT(!rwlock_held_by_current_thread(rw));
+
+    struct thread *cur = thread_current();
+    enum intr_level old_level = intr_disable();
+    struct rw_hold *hold = rw_hold_find(cur, NULL);
+    ASSERT(hold != NULL); // RW_HOLD_MAX개보다 많은 rwlock을 동시에 보유할 수 없음
+
+    while (rw->writer != NULL || rw->waiting_writers > 0)
+        rwlock_wait(rw, &rw->read_waiters);
+
+    hold->rwlock = rw;
+    hold->holder = cur;
+    list_push_back(&rw->readers, &hold->elem);
+    if (!thread_mlfqs)
+        thread_refresh_priority(cur); // 아직 기다리는 스레드가 있다면 그 Donation을 이어받음
+    intr_set_level(old_level);
+}
+
+/* 공유 모드로 보유한 rwlock을 풀어주는 함수 ; 마지막 reader였다면 대기자를 깨움 */
+void rwlock_release_read(struct rwlock *rw) {
+
+    ASSERT(rw != NULL);
+
+    struct thread *cur = thread_current();
+    enum intr_level old_level = intr_disable();
+    struct rw_hold *hold = rw_hold_find(cur, rw);
+    ASSERT(hold != NULL && rw->writer != cur);
+
+    list_remove(&hold->elem);
+    hold->rwlock = NULL;
+    if (!thread_mlfqs)
+        thread_refresh_priority(cur);
+
+    if (list_empty(&rw->readers))
+        rwlock_wake(rw);
+    intr_set_level(old_level);
+}
+
+/* rwlock을 배타 (쓰기) 모드로 확보하는 함수.
+   대기하는 동안에는 waiting_writers에 포함되어 새 reader들이 들어오지 못하게 막음. */
+void rwlock_acquire_write(struct rwlock *rw) {
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+    ASSERT(!rwlock_held_by_current_thread(rw));
+
+    struct thread *cur = thread_current();
+    enum intr_level old_level = intr_disable();
+    struct rw_hold *hold = rw_hold_find(cur, NULL);
+    ASSERT(hold != NULL);
+
+    rw->waiting_writers++;
+    while (rw->writer != NULL || !list_empty(&rw->readers))
+        rwlock_wait(rw, &rw->write_waiters);
+    rw->waiting_writers--;
+
+    rw->writer = cur;
+    hold->rwlock = rw;
+    hold->holder = cur;
+    if (!thread_mlfqs)
+        thread_refresh_priority(cur);
+    intr_set_level(old_level);
+}
+
+/* 배타 모드로 보유한 rwlock을 풀어주는 함수 */
+void rwlock_release_write(struct rwlock *rw) {
+
+    ASSERT(rw != NULL);
+    ASSERT(rw->writer == thread_current());
+
+    struct thread *cur = thread_current();
+    enum intr_level old_level = intr_disable();
+    struct rw_hold *hold = rw_hold_find(cur, rw);
+
+    rw->writer = NULL;
+    hold->rwlock = NULL;
+    if (!thread_mlfqs)
+        thread_refresh_priority(cur);
+
+    rwlock_wake(rw);
+    intr_set_level(old_level);
+}
+
+/* 현재 스레드가 해당 rwlock을 (어느 모드로든) 보유하고 있는지 확인하는 함수 */
+bool rwlock_held_by_current_thread(const struct rwlock *rw) {
+
+    ASSERT(rw != NULL);
+
+    return rw_hold_find(thread_current(), rw) != NULL;
+}
+
+/* rwlock을 기다리는 스레드들 중 가장 높은 우선순위를 반환 (대기자가 없다면 PRI_MIN - 1) */
+int rwlock_donated_priority(const struct rwlock *rw) {
+    struct heap_elem *top = heap_top((struct heap *)&rw->donors);
+
+    return top != NULL ? heap_entry(top, struct thread, donor_elem)->priority : PRI_MIN - 1;
+}
+
+/* 스레드 T의 rw_holds에서 RW를 보유한 슬롯을 찾는 함수 (RW가 NULL이면 빈 슬롯) */
+static struct rw_hold *rw_hold_find(struct thread *t, const struct rwlock *rw) {
+
+    for (int i = 0; i < RW_HOLD_MAX; i++)
+        if (t->rw_holds[i].rwlock == rw)
+            return &t->rw_holds[i];
+    return NULL;
+}
+
+/* 현재 스레드를 WAITERS에 넣고 Block (Interrupt가 꺼진 상태에서 호출).
+   기다리는 동안 우선순위를 rwlock의 모든 소유자에게 기부하며, 깨어나면 donor에서 빠짐. */
+static void rwlock_wait(struct rwlock *rw, struct waitqueue *waiters) {
+
+    struct thread *cur = thread_current();
+
+    waitqueue_push(waiters, cur);
+    if (!thread_mlfqs) {
+        cur->waiting_for_rwlock = rw;
+        heap_push(&rw->donors, &cur->donor_elem);
+        rwlock_donate(rw);
+    }
+
+    thread_block();
+
+    if (!thread_mlfqs) {
+        heap_remove(&rw->donors, &cur->donor_elem);
+        cur->waiting_for_rwlock = NULL;
+    }
+}
+
+/* rwlock이 비었을 때 대기자를 깨우는 함수 ; 쓰기 대기자가 있다면 가장 높은 우선순위의 writer 하나, 없다면 모든 reader.
+   깨어난 스레드들은 직접 조건을 다시 확인 (Mesa 스타일). */
+static void rwlock_wake(struct rwlock *rw) {
+
+    struct thread *t;
+
+    if (!waitqueue_empty(&rw->write_waiters))
+        thread_unblock(waitqueue_pop(&rw->write_waiters)); // 우선순위가 가장 높은 writer
+    else
+        while ((t = waitqueue_pop(&rw->read_waiters)) != NULL)
+            thread_unblock(t);
+    thread_check_yield();
+}
+
+/* RW의 donors가 바뀌었을 때 모든 소유자 (writer 혹은 모든 reader)에게 Donation을 전파하는 함수.
+   우선순위가 바뀐 소유자가 다른 락이나 rwlock을 기다리고 있다면 거기서부터 계속 전파. */
+static void rwlock_donate(struct rwlock *rw) {
+
+    struct list_elem *e;
+
+    if (rw->writer != NULL) {
+        int old_priority = rw->writer->priority;
+        thread_refresh_priority(rw->writer);
+        if (rw->writer->priority != old_priority)
+            donate_onward(rw->writer);
+    }
+
+    for (e = list_begin(&rw->readers); e != list_end(&rw->readers); e = list_next(e)) {
+        struct thread *reader = list_entry(e, struct rw_hold, elem)->holder;
+        int old_priority = reader->priority;
+        thread_refresh_priority(reader);
+        if (reader->priority != old_priority)
+            donate_onward(reader);
+    }
+}
+
+/* 우선순위가 바뀐 스레드 T가 기다리는 락이나 rwlock이 있다면, 그 donors에서 위치를 갱신하고 소유자에게 전파 */
+static void donate_onward(struct thread *t) {
+
+    if (t->waiting_for_lock != NULL) {
+        heap_update(&t->waiting_for_lock->donors, &t->donor_elem);
+        donate_priority(t->waiting_for_lock);
+    } else if (t->waiting_for_rwlock != NULL) {
+        heap_update(&t->waiting_for_rwlock->donors, &t->donor_elem);
+        rwlock_donate(t->waiting_for_rwlock);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///////////////////////////// Conditional Variables ////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
 /* struct condition (synch.h)를 초기화.
    아주 기본적인 condVar는 특정 코드가 시그널을 주면, 협조하는 코드가 수행될 수 있도록 하는 구조 */
 void cond_init(struct condition *cond) {
     ASSERT(cond != NULL);
 
-    /* PintOS에서 struct cond는 struct list waiters 단 하나의 멤버만 보유 */
-    list_init(&cond->waiters);
+    /* PintOS에서 struct cond는 waiters 단 하나의 멤버만 보유 */
+    waitqueue_init(&cond->waiters);
 }
 
 /* 락을 확보 한 상태에서, 특정 컨디션이 충족 되어 signal을 받기 전까지 락을 풀고 대기.
@@ -268,26 +733,24 @@ void cond_wait(struct condition *cond, struct lock *lock) {
 
     struct thread *curr = thread_current();
 
-    /* cond_wait()을 실행하기 위한 전용 semaphore_elem 선언 (waiters에 삽입되니 waiters로 명명) */
-    struct semaphore_elem waiter;
-
     /* 함수 실행을 위한 조건들을 충족하는지 확인 */
     ASSERT(cond != NULL);
     ASSERT(lock != NULL);
     ASSERT(!intr_context());
     ASSERT(lock_held_by_current_thread(lock));
 
-    /* cond_wait()을 실행하기 위한 전용 sema를 선언 */
-    sema_init(&waiter.semaphore, 0);
-
-    /* condition의 멤버인 waiters에 새로 생성한 waiter의 elem을 우선순위에 따라 추가 */
-    list_insert_ordered(&cond->waiters, &waiter.elem, sema_priority_comparison, NULL);
-
-    /* 현재 스레드끼리 경쟁중인 락을 릴리즈 하고, cond_signal/broadcast()가 해당 waiter.semaphore를 1로 만들떄 까지 대기 */
+    /* 스레드가 직접 cond의 waitqueue에 들어가서 기다림 (예전처럼 waiter마다 semaphore를 두지 않음).
+       Interrupt를 끈 채로 락을 릴리즈 해야 signal을 놓치지 않음 */
+    enum intr_level old_level = intr_disable();
+    waitqueue_push(&cond->waiters, curr);
     lock_release(lock);
-    sema_down(&waiter.semaphore);
 
-    /* sema_down()에 성공했으니 락 확보 */
+    /* lock_release() 도중 양보 (thread_check_yield)해서 READY인 동안 이미 signal을 받았다면 Block하지 않음 */
+    if (curr->waitqueue == &cond->waiters)
+        thread_block();
+    intr_set_level(old_level);
+
+    /* signal을 받았으니 락 다시 확보 */
     lock_acquire(lock);
 }
 
@@ -307,14 +770,22 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED) {
     ASSERT(!intr_context());
     ASSERT(lock_held_by_current_thread(lock));
 
-    /* cond의 waiters (유일한 멤버) 리스트가 비어있지 않다면, */
-    if (!list_empty(&cond->waiters)) {
-
-        /* 해당 리스트를 우선순위에 따라 한번 졍렬한 뒤 제일 우선순위 높은 waiter의 sema를 상향 조정 */
-        list_sort(&cond->waiters, sema_priority_comparison, NULL);
-        /* cond->waiters에 있는 하나의 waiter(semaphore_elem의 elem)을 뽑아서 -> semaphore_elem으로 전환한 뒤, 실제 semaphore로 진입 (child-parent-diff.child) -> sema_up() 실행 */
-        sema_up(&list_entry(list_pop_front(&cond->waiters), struct semaphore_elem, elem)->semaphore);
+    /* 우선순위가 가장 높은 대기자를 꺼내서 깨움 (O(log n)) ; 아직 Block 전이라면 (cond_wait 참고) 꺼내기만 하면 됨 */
+    enum intr_level old_level = intr_disable();
+    struct thread *t = waitqueue_pop(&cond->waiters);
+    if (t != NULL && t->status == THREAD_BLOCKED) {
+        thread_unblock(t);
+        thread_check_yield();
     }
+    intr_set_level(old_level);
+}
+
+/* COND에 signal을 줄 것으로 기대되는 스레드 OWNER를 지정하는 함수 (NULL이면 해제).
+   cond_wait()으로 기다리는 스레드들이 OWNER에게 우선순위를 기부 (sema_set_owner()와 같음). */
+void cond_set_owner(struct condition *cond, struct thread *owner) {
+    ASSERT(cond != NULL);
+
+    waitqueue_set_owner(&cond->waiters, owner);
 }
 
 /* cond->waiters의 모든 구성원들에게 cond_signal을 날리는 함수. */
@@ -322,6 +793,6 @@ void cond_broadcast(struct condition *cond, struct lock *lock) {
     ASSERT(cond != NULL);
     ASSERT(lock != NULL);
 
-    while (!list_empty(&cond->waiters))
+    while (!waitqueue_empty(&cond->waiters))
         cond_signal(cond, lock);
 }
@@ -1,16 +1,21 @@
 // clang-format off
 #include "threads/thread.h"
+#include "devices/timer.h"
 #include "filesys/filesys.h" // 추가
 #include "intrinsic.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include <debug.h>
 #include <hash.h> // SPT 해시테이블을 위해서 추가
 #include <random.h>
+#include <round.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -26,14 +31,25 @@
 #define THREAD_MAGIC 0xcd6abf4b // Struct Thread를 위한 Magic Number (스택 오버플로우 감지용)
 #define THREAD_BASIC 0xd42df210 // Basic Thread를 위한 랜덤 값 (수정 금지)
 #define TIME_SLICE 4            // 각 스레드마다 부여되는 Timer Tick의 크기
+#define PRIORITY_UPDATE_TICKS 4 // MLFQS에서 우선순위를 다시 계산하는 주기 (Timer Tick 단위)
+#define RUSAGE_HISTORY 32       // 종료 시 출력을 위해 자원 사용량을 보관해두는, 최근에 종료된 스레드의 수
+#define PAGE_CACHE_SIZE 16      // 종류별로 재활용을 위해 보관해두는 페이지의 최대 수
+#define EDF_UTIL_SCALE 1000000  // EDF 이용률 (runtime / period)을 정수로 표현하기 위한 단위 (1.0 = EDF_UTIL_SCALE)
+
+#if PRI_MAX - PRI_MIN + 1 > 64
+#error ready_bitmap은 최대 64개의 우선순위 레벨만 표현 가능
+#endif
 
 static struct thread *idle_thread;    // 스케쥴링할 스레드가 없을 때 호출되는 특수한 스레드 - Idle thread
 static struct thread *initial_thread; // Init.c의 main()에서 운영되는 최초의 스레드 - Initial thread
 static struct lock tid_lock;          // Allocate_tid()에서 사용되는 락
 
-static struct list ready_list;      // THREAD_READY로 대기중인 프로세스들을 위한 리스트 (Run 준비 완료 상태)
-static struct list sleep_list;      // Sleep 상태의 스레드들을 저장해두는 리스트 (우선순위가 높으면 앞에 배치)
+static struct list ready_queue[PRI_MAX + 1]; // THREAD_READY로 대기중인 스레드들을 우선순위별로 저장하는 FIFO 리스트들 (PRI_MIN..PRI_MAX)
+static uint64_t ready_bitmap;                 // ready_queue[i]가 비어있지 않다면 i번째 비트가 1 (가장 높은 비트가 최고 우선순위)
+static struct heap sleep_heap;      // Sleep 상태의 스레드들을 저장해두는 min-heap (wake_tick이 가장 작은 스레드가 top)
 static struct list destruction_req; // 삭제할 스레드들을 임시 저장하는 리스트 (do_schedule에서 처리)
+static struct list all_list;        // 살아있는 모든 스레드들의 리스트 (MLFQS의 1초 단위 일괄 갱신에서 순회)
+static int ready_cnt;               // ready_queue에 들어있는 스레드의 수 (load_avg 계산용)
 
 /* 시스템 통계 및 타이머에서 활용하는 Ticks */
 
@@ -42,19 +58,82 @@ static long long kernel_ticks; // Kernel 스레드가 사용한 Timer Tick의 
 static long long user_ticks;   // User Program에서 사용된 Timer Tick의 수
 static unsigned thread_ticks;  // 마지막 Yield 이후로 지난 Timer Tick의 수
 
+/* MLFQS 전용 전역 값 및 통계 */
+
+static fixed_t load_avg;                                           // 최근 1분간 Run 가능한 스레드 수의 이동 평균 (fixed-point)
+static struct thread *recent_cpu_changed[PRIORITY_UPDATE_TICKS];   // 마지막 우선순위 갱신 이후 recent_cpu가 바뀐 스레드들 (매 tick 최대 1개씩 추가)
+static int recent_cpu_changed_cnt;                                 // recent_cpu_changed에 들어있는 스레드의 수
+static long long mlfqs_ticks;                                      // MLFQS 계산을 수행한 Timer Tick의 수
+static uint64_t mlfqs_cycles;                                      // MLFQS 계산에 사용된 총 TSC cycle 수
+static uint64_t mlfqs_max_cycles;                                  // 한 Tick에서 MLFQS 계산에 사용된 최대 TSC cycle 수
+
+/* EDF 스케쥴링 클래스 ; 우선순위 클래스보다 먼저 스케쥴링되며, 그 안에서는 마감이 가장 이른 스레드가 먼저 실행됨 */
+
+static struct heap edf_ready_heap;  // READY 상태이면서 예산이 남은 EDF 스레드들 (마감이 가장 이른 스레드가 top)
+static struct heap edf_member_heap; // EDF 클래스의 모든 스레드들 (다음 주기 갱신이 가장 이른 스레드가 top)
+static long edf_utilization;        // EDF 스레드들의 runtime / period 합 (EDF_UTIL_SCALE 이하로 Admission control)
+static bool edf_used;               // EDF 클래스가 한번이라도 사용되었다면 true (thread_tick 오버헤드 방지용)
+static long long edf_misses;        // 전체 EDF 스레드의 마감 초과 횟수
+static long long edf_throttles;     // 예산을 다 써서 우선순위 클래스로 강등된 횟수
+
+/* 종료된 스레드들의 자원 사용량 기록 (스레드 페이지는 해제되니 종료 시점에 복사해서 보관) */
+
+struct rusage_record {
+    tid_t tid;
+    char name[16];
+    struct rusage rusage;
+};
+static struct rusage_record rusage_history[RUSAGE_HISTORY]; // 최근에 종료된 스레드들의 기록 (Ring buffer)
+static long long rusage_exited;                             // 지금까지 종료된 스레드의 수 (rusage_history의 다음 위치 계산용)
+
+/* 종료된 스레드의 스레드 페이지와 fd_table 페이지를 palloc에 돌려주지 않고 재활용하기 위한 캐시.
+   스레드 페이지는 init_thread()가 struct thread 부분만 초기화하면 되고,
+   fd_table은 fd_table_close()가 모든 fd를 NULL로 비운 상태로 반환되니 다시 0으로 채울 필요가 없음. */
+
+struct page_cache {
+    void *pages[PAGE_CACHE_SIZE]; // 재활용 대기 중인 페이지들 (Stack처럼 마지막에 들어온 페이지부터 사용)
+    int cnt;                      // pages에 들어있는 페이지의 수
+    long long hits;               // 캐시에서 페이지를 꺼내 쓴 횟수
+    long long misses;             // 캐시가 비어서 palloc을 호출한 횟수
+};
+static struct page_cache thread_page_cache; // 스레드 페이지 (struct thread + 커널 스택)
+static struct page_cache fd_table_cache;    // fd_table 페이지
+
 /* MLFQS 사용 여부를 반환 ; 기본값은 False이며, Round-robin 스케쥴러를 활용한다는 의미 ("-o mlfqs"로 통제) */
 
 bool thread_mlfqs;
 
+/* 커널 스레드 간 전환에 switch_fast() 경로를 사용할지 여부 */
+bool thread_fast_switch = true;
+
 /* Static 함수 프로토타입 (Thread.c로 한정되어 사용되는 함수들 ; 기타 나머지는 Thread.h 참고) */
 
 static void kernel_thread(thread_func *, void *aux);
+static void thread_launch_frame(struct thread *);
 static void idle(void *aux UNUSED);
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
+static void ready_queue_push(struct thread *);
+static struct thread *ready_queue_pop(void);
+static int ready_queue_max_priority(void);
+static void ready_queue_remove(struct thread *);
+static bool ready_queue_preempts(struct thread *);
+static bool edf_active(const struct thread *);
+static void edf_tick(struct thread *, int64_t now);
+static void edf_replenish(struct thread *, int64_t now);
+static void edf_leave(struct thread *);
+static bool edf_ready_comparison(const struct heap_elem *, const struct heap_elem *, void *aux);
+static bool edf_member_comparison(const struct heap_elem *, const struct heap_elem *, void *aux);
+static void mlfqs_tick(struct thread *, int64_t ticks);
+static void mlfqs_update_priority(struct thread *);
+static void mlfqs_update_recent_cpu(struct thread *);
+static void print_rusage(tid_t, const char *, const struct rusage *);
+static void *page_cache_get(struct page_cache *, enum palloc_flags);
+static void page_cache_put(struct page_cache *, void *);
+static void print_page_cache(const char *, const struct page_cache *);
 
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC) // Parameter가 Valid 스레드인지 여부 반환 (True/False)
 #define running_thread() ((struct thread *)(pg_round_down(rrsp()))) // 현재 스레드를 가리키는 포인터 반환 (스택 포인터 rsp를 페이지의 시작으로 round ; struct thread는 항상 맨앞에 위치)
@@ -81,16 +160,22 @@ void thread_init(void) {
     lgdt(&gdt_ds);
 
     /* 글로벌 Thread Context를 초기화 */
-    lock_init(&tid_lock);
-    list_init(&ready_list);
-    list_init(&sleep_list);
+    lock_init_named(&tid_lock, "tid_lock");
+    for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+        list_init(&ready_queue[pri]);
+    ready_bitmap = 0;
+    heap_init(&sleep_heap, comparison_for_sleepheap_insertion, NULL);
+    heap_init(&edf_ready_heap, edf_ready_comparison, NULL);
+    heap_init(&edf_member_heap, edf_member_comparison, NULL);
     list_init(&destruction_req);
+    list_init(&all_list);
 
     /* 구동되기 시작한 Initial Thread의 Struct Thread 값을 설정 */
     initial_thread = running_thread();
     init_thread(initial_thread, "main", PRI_DEFAULT);
     initial_thread->status = THREAD_RUNNING;
     initial_thread->tid = allocate_tid();
+    trace_thread_name(initial_thread->tid, initial_thread->name);
 }
 
 /* Preemptive 스케쥴링 시스템을 구동시키는 함수. */
@@ -108,8 +193,10 @@ void thread_start(void) {
     sema_down(&idle_started);
 }
 
-/* Timer Interrupt Handler가 매 틱마다 호출하는 함수 (External Interrupt Context 전용) */
-void thread_tick(void) {
+/* Timer Interrupt Handler가 매 틱마다 호출하는 함수 (External Interrupt Context 전용).
+   TICK은 처리 중인 Tick 번호 ; Tickless 모드에서는 One-shot 하나가 여러 Tick을 한번에 처리하고,
+   그동안 timer_ticks()는 마지막 Tick을 반환하니 Tick 단위 갱신은 반드시 TICK을 기준으로 해야 함 */
+void thread_tick(int64_t tick) {
 
     struct thread *t = thread_current();
 
@@ -123,17 +210,112 @@ void thread_tick(void) {
     else
         kernel_ticks++;
 
+    /* MLFQS 사용시 recent_cpu, load_avg, 우선순위를 갱신 */
+    if (thread_mlfqs)
+        mlfqs_tick(t, tick);
+
+    /* EDF 스레드의 예산 차감 및 주기 갱신 */
+    if (edf_used)
+        edf_tick(t, tick);
+
     /* Preemption이 자동으로 TIME_SLICE마다 발생하도록 함 */
     if (++thread_ticks >= TIME_SLICE)
         intr_yield_on_return();
 }
 
 /* 스레드 관련 통계치들을 출력하는 함수 */
-void thread_print_stats(void) { printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks, kernel_ticks, user_ticks); }
+void thread_print_stats(void) {
+    printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks, kernel_ticks, user_ticks);
+    if (thread_mlfqs && mlfqs_ticks > 0)
+        printf("MLFQS: %llu cycles/tick average, %llu cycles max over %lld ticks\n", mlfqs_cycles / mlfqs_ticks, mlfqs_max_cycles, mlfqs_ticks);
+    if (edf_used)
+        printf("EDF: %lld deadline misses, %lld budget overruns\n", edf_misses, edf_throttles);
+}
+
+/* 스레드 페이지와 fd_table 페이지 캐시의 적중률을 출력하는 함수 (palloc_print_stats()가 Palloc 통계에 이어서 호출) */
+void thread_print_page_caches(void) {
+    print_page_cache("Thread page", &thread_page_cache);
+    print_page_cache("fd_table page", &fd_table_cache);
+}
+
+/* 페이지 캐시의 적중률을 한 줄로 출력하는 함수 */
+static void print_page_cache(const char *kind, const struct page_cache *cache) {
+    long long total = cache->hits + cache->misses;
+
+    printf("%s cache: %lld hits, %lld misses (%lld%% hit rate), %d cached\n", kind, cache->hits, cache->misses,
+           total > 0 ? cache->hits * 100 / total : 0, cache->cnt);
+}
+
+/* CACHE에서 페이지를 하나 꺼내는 함수 ; 비어있다면 FLAGS로 palloc_get_page()를 호출 */
+static void *page_cache_get(struct page_cache *cache, enum palloc_flags flags) {
+
+    enum intr_level old_level = intr_disable();
+    void *page = NULL;
+
+    if (cache->cnt > 0) {
+        page = cache->pages[--cache->cnt];
+        cache->hits++;
+    } else
+        cache->misses++;
+    intr_set_level(old_level);
+
+    return page != NULL ? page : palloc_get_page(flags);
+}
+
+/* PAGE를 CACHE에 보관하는 함수 ; 캐시가 가득 찼다면 palloc에 반환 (do_schedule에서 Interrupt를 끈 상태로 호출) */
+static void page_cache_put(struct page_cache *cache, void *page) {
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (page == NULL)
+        return;
+    if (cache->cnt < PAGE_CACHE_SIZE)
+        cache->pages[cache->cnt++] = page;
+    else
+        palloc_free_page(page);
+}
+
+/* 현재 스레드의 자원 사용량을 USAGE에 저장하는 함수 (진행 중인 RUNNING 시간까지 포함). */
+void thread_get_rusage(struct rusage *usage) {
+
+    enum intr_level old_level = intr_disable();
+    struct thread *curr = thread_current();
+
+    *usage = curr->rusage;
+    usage->cpu_cycles += rdtsc() - curr->state_since;
+    intr_set_level(old_level);
+}
+
+/* 살아있는 스레드들과 최근에 종료된 스레드들의 자원 사용량을 출력하는 함수 (종료 시 print_stats에서 호출).
+   CPU를 오래 기다리는 (Starved) 스레드나 Context switch가 잦은 스레드를 찾는 용도. */
+void thread_print_rusage(void) {
+
+    enum intr_level old_level = intr_disable();
+    long long first = rusage_exited > RUSAGE_HISTORY ? rusage_exited - RUSAGE_HISTORY : 0;
+
+    printf("Thread usage (Kcycles):  tid name             running      ready    blocked  vol-csw  inv-csw\n");
+    for (struct list_elem *e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+        struct thread *t = list_entry(e, struct thread, all_elem);
+        print_rusage(t->tid, t->name, &t->rusage);
+    }
+    for (long long i = first; i < rusage_exited; i++) {
+        struct rusage_record *r = &rusage_history[i % RUSAGE_HISTORY];
+        print_rusage(r->tid, r->name, &r->rusage);
+    }
+    if (first > 0)
+        printf("  (%lld older exited threads not shown)\n", first);
+    intr_set_level(old_level);
+}
+
+/* thread_print_rusage()에서 스레드 하나의 자원 사용량을 한 줄로 출력하는 함수 */
+static void print_rusage(tid_t tid, const char *name, const struct rusage *r) {
+    printf("%28d %-16s %10llu %10llu %10llu %8llu %8llu\n", tid, name, r->cpu_cycles / 1000, r->ready_cycles / 1000,
+           r->blocked_cycles / 1000, r->voluntary_switches, r->involuntary_switches);
+}
 
 /* 새로은 커널 스레드를 생성하는 함수.
    Name 및 Priority를 부여하고, Function/Aux를 실행하는 스레드.
-   생성 이후 ready_list에 삽입되며, 성공하면 TID를, 실패하면 에러를 반환. */
+   생성 이후 ready_queue에 삽입되며, 성공하면 TID를, 실패하면 에러를 반환. */
 tid_t thread_create(const char *name, int priority, thread_func *function, void *aux) {
 
     struct thread *t;
@@ -141,31 +323,40 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
 
     ASSERT(function != NULL);
 
-    /* 스레드에 페이지 부여 */
-    t = palloc_get_page(PAL_ZERO);
-    if (t == NULL) {
-        palloc_free_page(t);
+    /* 스레드에 페이지 부여 (struct thread는 init_thread에서 초기화하니 페이지 전체를 0으로 채울 필요 없음) */
+    t = page_cache_get(&thread_page_cache, 0);
+    if (t == NULL)
         return TID_ERROR;
-    }
 
     /* 스레드 초기화 작업 */
     init_thread(t, name, priority);
     tid = t->tid = allocate_tid();
+    trace_thread_name(tid, name);
+
+    /* MLFQS에서는 nice와 recent_cpu를 부모에게서 물려받고, 우선순위는 인자 대신 직접 계산 (Idle Thread는 PRI_MIN 유지) */
+    if (thread_mlfqs && function != idle) {
+        t->nice = thread_current()->nice;
+        t->recent_cpu = thread_current()->recent_cpu;
+        mlfqs_update_priority(t);
+    }
 
     // #ifdef USERPROG
 
     /* fd_table의 메모리 부여 및 락 초기화가 여기서 일어나야 문제가 없음 */
-    t->fd_table = (struct file **)palloc_get_page(PAL_ZERO); // Kernel-side에 0으로 초기화된 페이지를 새로 Allocate
-    lock_init(&t->fd_lock);
+    t->fd_table = (struct file **)page_cache_get(&fd_table_cache, PAL_ZERO); // 0으로 초기화된 (또는 모든 fd가 닫힌 채로 반환된) 페이지
+    lock_init_named(&t->fd_lock, "fd_lock");
 
     /* 스레드 생성 시점부터 parent의 children list에 바로 추가 */
     list_push_back(&thread_current()->children_list, &t->child_elem); // 부모 스레드의 children_list에 자식 스레드를 추가
     t->parent_is = thread_current();
     t->fork_depth = t->parent_is->fork_depth + 1;
 
+    /* wait_sema는 자식이 process_exit에서 up 하니, wait() 중인 부모가 자식에게 우선순위를 기부하도록 owner로 지정 */
+    sema_set_owner(&t->wait_sema, t);
+
     // #endif
 
-    /* 커널 스레드가 ready_list에 있다면 호출, Function/Aux 값을 부여 */
+    /* 커널 스레드가 ready_queue에 있다면 호출, Function/Aux 값을 부여 */
     t->tf.rip = (uintptr_t)kernel_thread;
     t->tf.R.rdi = (uint64_t)function;
     t->tf.R.rsi = (uint64_t)aux;
@@ -175,19 +366,17 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
     t->tf.cs = SEL_KCSEG;
     t->tf.eflags = FLAG_IF;
 
-    /* 기본적인 스레드 골격을 생성했으니 ready_list에 삽입 */
+    /* 기본적인 스레드 골격을 생성했으니 ready_queue에 삽입 */
     thread_unblock(t);
 
-    /* 새로 생성된 스레드의 우선순위가 Run 중인 스레드보다 높다면 스케쥴러 호출 */
-    if (t->priority > thread_current()->priority) {
-        thread_yield();
-    }
+    /* 새로 생성된 스레드가 Run 중인 스레드보다 먼저 실행되어야 한다면 스케쥴러 호출 (EDF 스레드는 우선순위와 무관하게 유지) */
+    thread_check_yield();
 
     return tid;
 }
 
 /* 현재 Run 상태인 스레드를 Sleep 상태로 바꾸는 함수.
-   thread_unblock()으로 풀어주기 전까지 ready_list에 복귀 불가.
+   thread_unblock()으로 풀어주기 전까지 ready_queue에 복귀 불가.
    Interrupt를 끈 상태에서 호출해야하며, interrupt가 호출하는 형태는 복잡도가 급격히 증가하기 때문에 금지. */
 void thread_block(void) {
 
@@ -197,8 +386,8 @@ void thread_block(void) {
     schedule();
 }
 
-/* thread_block()으로 재워둔 스레드를 다시 ready_list로 복귀시키는 함수.
-   스레드가 block상태가 아니라면 에러를 반환 (따라서 Running 스레드를 ready_list로 넣을때는 사용 금지).
+/* thread_block()으로 재워둔 스레드를 다시 ready_queue로 복귀시키는 함수.
+   스레드가 block상태가 아니라면 에러를 반환 (따라서 Running 스레드를 ready_queue로 넣을때는 사용 금지).
 
    중요 : 이 함수는 기존에 Run 상태인 스레드를 Preempt 하지 않아야 함. */
 void thread_unblock(struct thread *t) {
@@ -208,8 +397,19 @@ void thread_unblock(struct thread *t) {
     enum intr_level old_level = intr_disable();
     ASSERT(t->status == THREAD_BLOCKED);
 
-    /* 우선순위가 높은 스레드가 앞으로 가도록 순서대로 스레드의 Elem을 ready_list에 삽입 */
-    list_insert_ordered(&ready_list, &t->elem, comparison_for_readylist_insertion, NULL);
+    /* Block 된 동안 지나간 EDF 주기들을 갱신 (Block 상태였으니 마감 초과로 세지 않음) */
+    if (t->edf_period > 0 && t->edf_deadline <= timer_ticks())
+        edf_replenish(t, timer_ticks());
+
+    trace_record(TRACE_UNBLOCK, thread_current()->tid, t->tid, 0, 0, 0);
+
+    /* BLOCKED 상태로 보낸 시간을 누적하고, 이제부터 READY 상태의 대기 시간을 측정 */
+    uint64_t now = rdtsc();
+    t->rusage.blocked_cycles += now - t->state_since;
+    t->state_since = now;
+
+    /* 스레드의 우선순위에 해당하는 ready_queue의 맨 뒤에 삽입 (같은 우선순위 내에서는 FIFO) */
+    ready_queue_push(t);
     t->status = THREAD_READY;
 
     /* Interrupt 활성화 */
@@ -221,32 +421,35 @@ void thread_sleep(int64_t wake_time_tick) {
     struct thread *curr = thread_current();
     enum intr_level old_level = intr_disable();
 
-    /* 만일 현재 스레드가 idle thread라면 재우면 안됨 */
+    /* 만일 현재 스레드가 idle thread라면 재우면 안됨 (상태가 RUNNING인 채로 schedule()을 부르면 안되니 같이 보호) */
     if (curr != idle_thread) {
         curr->wake_tick = wake_time_tick; // Struct Thread의 wake_tick 값을 설정 (잠에 깨야하는 Tick)
         curr->status = THREAD_BLOCKED;
-        list_insert_ordered(&sleep_list, &curr->elem, comparison_for_sleeplist_insertion, NULL);
+        heap_push(&sleep_heap, &curr->sleep_elem); // O(log n) 삽입
+        timer_arm(wake_time_tick);                 // Tickless 모드라면 진행 중인 One-shot이 wake_tick보다 늦게 끝나지 않도록 조정
+
+        /* schedule() 후속 작업을 위해서는 Interrupt가 꺼져있어야 함 ; 관련 작업 완료 후 추후 이 스레드로 돌아온다면 intr_set_level로 복귀해서 출발 */
+        schedule();
     }
 
-    /* schedule() 후속 작업을 위해서는 Interrupt가 꺼져있어야 함 ; 관련 작업 완료 후 추후 이 스레드로 돌아온다면 intr_set_level로 복귀해서 출발 */
-    schedule();
     intr_set_level(old_level);
 }
 
-/* ready_list에 스레드를 추가하기 위해서 우선순위를 비교하는, list_insert_ordered() 전용 함수 */
-bool comparison_for_readylist_insertion(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED) {
+/* thread_sleep()으로 자고 있는 T를 깨울 시간이 되기 전에 sleep_heap에서 빼는 함수 (호출자가 이어서 thread_unblock).
+   Interrupt가 꺼진 상태에서 호출해야 함. */
+void thread_sleep_cancel(struct thread *t) {
 
-    struct thread *t_new = list_entry(new, struct thread, elem);
-    struct thread *t_existing = list_entry(existing, struct thread, elem);
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t->status == THREAD_BLOCKED);
 
-    return t_new->priority > t_existing->priority;
+    heap_remove(&sleep_heap, &t->sleep_elem);
 }
 
-/* sleep_list에 스레드를 추가하기 위해서 깨야하는 시간 (목표 tick)을 비교하는, list_insert_ordered 전용 함수 */
-bool comparison_for_sleeplist_insertion(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED) {
+/* sleep_heap에 스레드를 추가하기 위해서 깨야하는 시간 (목표 tick)을 비교하는, heap_init 전용 함수 */
+bool comparison_for_sleepheap_insertion(const struct heap_elem *new, const struct heap_elem *existing, void *aux UNUSED) {
 
-    struct thread *t_new = list_entry(new, struct thread, elem);
-    struct thread *t_existing = list_entry(existing, struct thread, elem);
+    struct thread *t_new = heap_entry(new, struct thread, sleep_elem);
+    struct thread *t_existing = heap_entry(existing, struct thread, sleep_elem);
 
     return t_new->wake_tick < t_existing->wake_tick;
 }
@@ -254,20 +457,54 @@ bool comparison_for_sleeplist_insertion(const struct list_elem *new, const struc
 /* Timer.c의 timer_interrupt(), 즉 Interrupt Handler가 호출하는 함수 (스레드를 깨우는 역할) */
 void thread_wake(int64_t current_tick) {
 
-    /* sleep_list가 비어있는지 먼저 확인 후 하나씩 검토, 한번에 여러개를 깨워야 할 수도 있음 */
-    while (!list_empty(&sleep_list)) {
-        struct list_elem *target_elem_in_list = list_front(&sleep_list);
-        struct thread *target_thread_from_elem = list_entry(target_elem_in_list, struct thread, elem);
+    /* sleep_heap이 비어있는지 먼저 확인 후 하나씩 검토, 한번에 여러개를 깨워야 할 수도 있음 */
+    while (!heap_empty(&sleep_heap)) {
+        struct heap_elem *target_elem_in_heap = heap_top(&sleep_heap);
+        struct thread *target_thread_from_elem = heap_entry(target_elem_in_heap, struct thread, sleep_elem);
 
-        /* sleep_list는 깨워야하는 tick이 작을수록 앞에 있음 ; 따라서 조회하는 스레드의 wake tick이 시스템 값보다 크다면 멈춰도 됨 */
+        /* sleep_heap의 top은 깨워야하는 tick이 가장 작은 스레드 ; 따라서 top의 wake tick이 시스템 값보다 크다면 멈춰도 됨 */
         if (target_thread_from_elem->wake_tick > current_tick)
             break;
 
-        list_pop_front(&sleep_list);
+        heap_pop(&sleep_heap);
         thread_unblock(target_thread_from_elem);
     }
 }
 
+/* 가장 먼저 깨어나야 하는 스레드의 wake_tick을 반환하는 함수 (O(1) ; 자는 스레드가 없다면 INT64_MAX).
+   timer_interrupt()에서 thread_wake()를 호출할 필요가 있는지 미리 확인하는 용도. */
+int64_t thread_next_wake_tick(void) {
+
+    struct heap_elem *top = heap_top(&sleep_heap);
+
+    return top != NULL ? heap_entry(top, struct thread, sleep_elem)->wake_tick : INT64_MAX;
+}
+
+/* 현재 스레드의 Time slice가 끝나기까지 남은 Tick 수를 반환하는 함수 (Tickless 모드의 One-shot 길이 계산용).
+   Idle thread는 Preemption할 필요가 없으니 INT64_MAX를 반환. */
+int64_t thread_ticks_left(void) {
+
+    struct thread *curr = thread_current();
+    struct heap_elem *top = heap_top(&edf_member_heap);
+    int64_t left;
+
+    if (curr == idle_thread)
+        return INT64_MAX;
+
+    /* 이미 Time slice를 다 쓴 경우 곧 Yield하므로, 다음 스레드의 Time slice 전체를 반환 */
+    left = thread_ticks < TIME_SLICE ? TIME_SLICE - thread_ticks : TIME_SLICE;
+
+    /* EDF 스레드의 예산 소진과 다음 EDF 주기 갱신도 Tick이 있어야 처리됨 */
+    if (edf_active(curr) && curr->edf_budget < left)
+        left = curr->edf_budget;
+    if (top != NULL) {
+        int64_t until = heap_entry(top, struct thread, edf_member_elem)->edf_deadline - timer_ticks();
+        if (until < left)
+            left = until > 1 ? until : 1;
+    }
+    return left;
+}
+
 /* 현재 Run 중인 스레드를 가리키는 포인터를 반환하는 함수 (running_thread의 Wrapper함수). */
 struct thread *thread_current(void) {
     struct thread *t = running_thread();
@@ -295,8 +532,27 @@ void thread_exit(void) {
 
 #endif
 
+    /* magazine에 남은 블록들을 공용 free 리스트로 반납 (스레드 페이지와 함께 사라지지 않도록) */
+    malloc_drain();
+
     /* THREAD_DYING으로 지정하고 스케쥴러를 호출, do_schedule에서 삭제 대상들을 일괄 삭제 */
     intr_disable();
+    list_remove(&thread_current()->all_elem);
+
+    /* 곧 해제될 스레드에게 기부하지 않도록 owner로 지정된 waitqueue들을 모두 놓음 */
+    struct heap_elem *owned;
+    while ((owned = heap_top(&thread_current()->owned_queues)) != NULL)
+        waitqueue_set_owner(heap_entry(owned, struct waitqueue, owner_elem), NULL);
+
+    /* EDF 클래스에서 탈퇴해서 이용률을 반납 */
+    if (thread_current()->edf_period > 0)
+        edf_leave(thread_current());
+
+    /* 곧 해제될 페이지를 MLFQS 우선순위 갱신 대상에서 제외 */
+    for (int i = 0; i < recent_cpu_changed_cnt; i++)
+        if (recent_cpu_changed[i] == thread_current())
+            recent_cpu_changed[i] = recent_cpu_changed[--recent_cpu_changed_cnt];
+
     do_schedule(THREAD_DYING);
     NOT_REACHED();
 }
@@ -310,9 +566,9 @@ void thread_yield(void) {
     enum intr_level old_level = intr_disable();
     struct thread *curr = thread_current();
 
-    /* Idle thread에서는 구동되면 안되니 ready_list 삽입 코드를 보호 */
+    /* Idle thread에서는 구동되면 안되니 ready_queue 삽입 코드를 보호 */
     if (curr != idle_thread)
-        list_insert_ordered(&ready_list, &curr->elem, comparison_for_readylist_insertion, NULL); // (Edited)
+        ready_queue_push(curr);
 
     do_schedule(THREAD_READY);
     intr_set_level(old_level);
@@ -321,9 +577,9 @@ void thread_yield(void) {
 /* thread_yield를 하기 전에 한번 주요 조건들을 확인하는 Wrapper 함수. */
 void thread_check_yield(void) {
 
-    /* ready_list가 비어있지 않고, ready_list에서 제일 우선순위가 높은 스레드의 우선순위가 현재 run 중인 스레드의 우선순위보다 높을 경우 */
+    /* ready_queue에서 제일 높은 우선순위가 현재 run 중인 스레드의 우선순위보다 높을 경우 (비어있다면 -1이 반환되어 자동으로 제외) */
     /* project 2 하면서 추가 : interrupt handler가 디스크 loading 시점에서 sema_up을 하기도 함 ; 따라서 !intr_context() 필수 */
-    if (!list_empty(&ready_list) && list_entry(list_front(&ready_list), struct thread, elem)->priority > thread_current()->priority && !intr_context()) {
+    if (ready_queue_preempts(thread_current()) && !intr_context()) {
         thread_yield();
     }
 }
@@ -331,64 +587,333 @@ void thread_check_yield(void) {
 /* 현재 Run 중인 스레드의 우선순위를 변경하는 함수 */
 void thread_set_priority(int new_priority) {
 
-    /* 스레드의 우선순위 값들을 변경 (부스트 목적이 아닌 전체 변경) */
+    /* MLFQS에서는 우선순위를 스케쥴러가 직접 계산하니 무시 */
+    if (thread_mlfqs)
+        return;
+
+    /* 스레드의 원래 우선순위를 변경하고, 기부받은 우선순위가 더 높다면 그 값을 유지 (O(1)) */
+    enum intr_level old_level = intr_disable();
     thread_current()->priority_original = new_priority;
-    thread_current()->priority = new_priority;
+    thread_refresh_priority(thread_current());
+    intr_set_level(old_level);
+
+    /* thread_yield 전용 Wrapper 함수로, 조건부 thread_yield 수행 (ready_queue에 현재 스레드보다 먼저 실행되어야 하는 스레드가 있을 경우) */
+    thread_check_yield();
+}
 
-    /* Donation 수행 */
-    if (!list_empty(&thread_current()->donations)) {                                     // 현재 스레드의 Donation 리스트에 내용물이 있다면,
-        list_sort(&thread_current()->donations, comparison_for_priority_donation, NULL); // 해당 리스트를 우선순위에 따라 정렬하고,
+/* 스레드 T의 우선순위를 원래 우선순위와 보유 중인 락 (및 rwlock, 소유한 waitqueue)들이 받는 Donation 중 가장 높은 값으로 다시 계산하는 함수.
+   held_locks의 top만 보면 되니 O(1)이며 (rwlock은 최대 RW_HOLD_MAX개), T가 READY라면 ready_queue의 위치도 새 우선순위에 맞게 옮김.
+   Interrupt를 끈 상태에서 호출해야 함. */
+void thread_refresh_priority(struct thread *t) {
 
-        // 정렬된 리스트에서 제일 우선순위가 높은 스레드를 정의한 뒤에,
-        struct thread *t = list_entry(list_front(&thread_current()->donations), struct thread, donation_elem);
+    ASSERT(intr_get_level() == INTR_OFF);
 
-        if (t->priority > thread_current()->priority) { // 만일 해당 스레드의 우선순위가 현재 스레드보다 더 높다면,
-            thread_current()->priority = t->priority;   // 현재 스레드의 우선순위를 업데이트.
-        }
+    int priority = t->priority_original;
+    struct heap_elem *top = heap_top(&t->held_locks);
+
+    if (top != NULL) {
+        int donated = lock_donated_priority(heap_entry(top, struct lock, holder_elem));
+        if (donated > priority)
+            priority = donated;
     }
 
-    /* thread_yield 전용 Wrapper 함수로, 조건부 thread_yield 수행 (ready_list에 현재 스레드보다 우선순위가 높은 스레드가 있을 경우) */
-    thread_check_yield();
-}
+    /* 깨워주기로 지정된 semaphore, cond 등의 대기자들도 마찬가지로 top만 확인 */
+    top = heap_top(&t->owned_queues);
+    if (top != NULL) {
+        int donated = waitqueue_donated_priority(heap_entry(top, struct waitqueue, owner_elem));
+        if (donated > priority)
+            priority = donated;
+    }
+
+    /* 보유 중인 rwlock들은 개수가 적으니 (RW_HOLD_MAX) 직접 훑어봄 */
+    for (int i = 0; i < RW_HOLD_MAX; i++) {
+        if (t->rw_holds[i].rwlock != NULL) {
+            int donated = rwlock_donated_priority(t->rw_holds[i].rwlock);
+            if (donated > priority)
+                priority = donated;
+        }
+    }
 
-/* thread_set_priority 전용 헬퍼 함수 */
-bool comparison_for_priority_donation(const struct list_elem *new, const struct list_elem *existing, void *aux UNUSED) {
+    if (priority == t->priority)
+        return;
 
-    struct thread *t_new = list_entry(new, struct thread, donation_elem);
-    struct thread *t_existing = list_entry(existing, struct thread, donation_elem);
+    /* ready_queue_remove는 기존 우선순위의 큐를 참조하니, 우선순위를 바꾸기 전에 제거 */
+    if (t->status == THREAD_READY) {
+        ready_queue_remove(t);
+        t->priority = priority;
+        ready_queue_push(t);
+    } else
+        t->priority = priority;
 
-    return t_new->priority > t_existing->priority;
+    /* semaphore 등을 기다리는 중이라면 waitqueue 내 위치도 갱신 (O(log n)) */
+    if (t->waitqueue != NULL)
+        waitqueue_update(t);
 }
 
 /* 현재 Run 중인 스레드의 우선순위 값을 호출하는 함수 */
 int thread_get_priority(void) { return thread_current()->priority; }
 
 ////////////////////////////////////////////////////////////////////////////////
-///////////////////////////// Thread.c 잠시 중단 /////////////////////////////////
+/////////////////////////////////// EDF ////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-/* 아래는 아직 활용하지 않는 함수들의 모음 (MLFQS 또는 기타 다른 작업에서 필요) */
+/* 현재 스레드를 주기 PERIOD마다 RUNTIME만큼의 실행 시간을 보장받는 EDF 클래스로 등록하는 함수 (단위는 Timer Tick).
+   모든 EDF 스레드의 이용률 (runtime / period) 합이 1을 넘는다면 거부하고 false를 반환 (Admission control).
+   이미 EDF 스레드라면 값을 변경하며, PERIOD와 RUNTIME이 모두 0이면 EDF 클래스에서 탈퇴해서 우선순위 클래스로 복귀. */
+bool thread_set_deadline(int64_t period, int64_t runtime) {
+
+    struct thread *curr = thread_current();
+    long util = 0;
+
+    /* 인자 검증 및 이용률 계산 (Admission control이 보수적이도록 올림) */
+    if (period != 0 || runtime != 0) {
+        if (runtime <= 0 || runtime > period)
+            return false;
+        util = DIV_ROUND_UP(runtime * EDF_UTIL_SCALE, period);
+    }
+
+    enum intr_level old_level = intr_disable();
+    long curr_util = curr->edf_period > 0 ? DIV_ROUND_UP(curr->edf_runtime * EDF_UTIL_SCALE, curr->edf_period) : 0;
+
+    if (edf_utilization - curr_util + util > EDF_UTIL_SCALE) {
+        intr_set_level(old_level);
+        return false;
+    }
+
+    if (curr->edf_period > 0)
+        edf_leave(curr);
+
+    /* 첫 주기는 지금부터 시작 */
+    if (period > 0) {
+        curr->edf_period = period;
+        curr->edf_runtime = runtime;
+        curr->edf_deadline = timer_ticks() + period;
+        curr->edf_budget = runtime;
+        heap_push(&edf_member_heap, &curr->edf_member_elem);
+        edf_utilization += util;
+        edf_used = true;
+    }
+    intr_set_level(old_level);
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED) { /* TODO: Your implementation goes here */
+    /* EDF 클래스에서 탈퇴했다면 더 높은 우선순위의 스레드에게 양보해야 할 수 있음 */
+    thread_check_yield();
+    return true;
 }
 
-/* Returns the current thread's nice value. */
-int thread_get_nice(void) {
-    /* TODO: Your implementation goes here */
-    return 0;
+/* 현재 스레드의 EDF 마감 초과 횟수를 반환하는 함수 */
+long long thread_get_deadline_misses(void) { return thread_current()->edf_misses; }
+
+/* T가 예산이 남아서 EDF 클래스로 스케쥴링되는 상태인지 확인하는 함수 */
+static bool edf_active(const struct thread *t) { return t->edf_period > 0 && t->edf_budget > 0; }
+
+/* Timer Tick마다 Run 중인 EDF 스레드의 예산을 차감하고, 마감이 지난 EDF 스레드들의 주기를 갱신하는 함수 (NOW는 처리 중인 Tick) */
+static void edf_tick(struct thread *t, int64_t now) {
+
+    struct heap_elem *top;
+
+    /* 예산을 다 쓴 스레드는 다음 주기까지 우선순위 클래스로 강등 */
+    if (edf_active(t) && --t->edf_budget == 0) {
+        edf_throttles++;
+        intr_yield_on_return();
+    }
+
+    while ((top = heap_top(&edf_member_heap)) != NULL) {
+        struct thread *m = heap_entry(top, struct thread, edf_member_elem);
+        if (m->edf_deadline > now)
+            break;
+        edf_replenish(m, now);
+    }
+
+    /* 주기 갱신으로 예산을 되찾은 스레드가 있다면 Interrupt 복귀 시점에 양보 */
+    if (ready_queue_preempts(t))
+        intr_yield_on_return();
 }
 
-/* Returns 100 times the system load average. */
+/* 마감이 지난 EDF 스레드 T의 마감을 NOW 이후의 다음 주기로 옮기고 예산을 다시 채우는 함수.
+   실행 가능한 상태인데도 예산이 남아있다면 보장받은 실행 시간을 받지 못한 것이니 마감 초과로 집계. */
+static void edf_replenish(struct thread *t, int64_t now) {
+
+    bool ready = t->status == THREAD_READY;
+
+    /* 예산이 바뀌면 들어가야 할 큐도 바뀌니, READY라면 꺼냈다가 다시 삽입 */
+    if (ready)
+        ready_queue_remove(t);
+
+    if (t->edf_budget > 0 && (ready || t->status == THREAD_RUNNING)) {
+        t->edf_misses++;
+        edf_misses++;
+    }
+
+    t->edf_deadline += ((now - t->edf_deadline) / t->edf_period + 1) * t->edf_period;
+    t->edf_budget = t->edf_runtime;
+    heap_update(&edf_member_heap, &t->edf_member_elem);
+
+    if (ready)
+        ready_queue_push(t);
+}
+
+/* T를 EDF 클래스에서 제외하고 이용률을 반납하는 함수 (Interrupt가 꺼진 상태 ; T는 RUNNING) */
+static void edf_leave(struct thread *t) {
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t->status == THREAD_RUNNING);
+
+    heap_remove(&edf_member_heap, &t->edf_member_elem);
+    edf_utilization -= DIV_ROUND_UP(t->edf_runtime * EDF_UTIL_SCALE, t->edf_period);
+    t->edf_period = 0;
+    t->edf_budget = 0;
+}
+
+/* edf_ready_heap 전용 비교 함수 ; 마감이 가장 이른 스레드가 top */
+static bool edf_ready_comparison(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+    return heap_entry(a, struct thread, edf_elem)->edf_deadline < heap_entry(b, struct thread, edf_elem)->edf_deadline;
+}
+
+/* edf_member_heap 전용 비교 함수 ; 다음 주기 갱신이 가장 이른 스레드가 top */
+static bool edf_member_comparison(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+    return heap_entry(a, struct thread, edf_member_elem)->edf_deadline < heap_entry(b, struct thread, edf_member_elem)->edf_deadline;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// MLFQS ///////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+/* 4.4BSD 스타일 MLFQS (17.14 fixed-point 기반, fixed-point.h 참고).
+   매 tick마다 모든 스레드를 갱신하면 스레드 수에 비례하는 비용이 Interrupt Context에서 발생하기 때문에,
+   (1) 매 tick : Run 중인 스레드의 recent_cpu만 1 증가시키고 '변경됨'으로 기록,
+   (2) 매 PRIORITY_UPDATE_TICKS : 기록된 (입력값이 바뀐) 스레드들의 우선순위만 재계산,
+   (3) 매 초 : load_avg 갱신 후 all_list를 한번 순회하며 recent_cpu와 우선순위를 일괄 재계산. */
+
+/* 현재 스레드의 nice 값을 설정하고, 우선순위를 다시 계산하는 함수 */
+void thread_set_nice(int nice) {
+
+    ASSERT(NICE_MIN <= nice && nice <= NICE_MAX);
+
+    enum intr_level old_level = intr_disable();
+    thread_current()->nice = nice;
+    mlfqs_update_priority(thread_current());
+    intr_set_level(old_level);
+
+    /* 우선순위가 낮아져서 더 높은 스레드가 있다면 양보 */
+    thread_check_yield();
+}
+
+/* 현재 스레드의 nice 값을 반환 */
+int thread_get_nice(void) { return thread_current()->nice; }
+
+/* load_avg의 100배를 반올림해서 반환 */
 int thread_get_load_avg(void) {
-    /* TODO: Your implementation goes here */
-    return 0;
+
+    enum intr_level old_level = intr_disable();
+    int load_avg_100 = fp_to_int_round(fp_mul_int(load_avg, 100));
+    intr_set_level(old_level);
+
+    return load_avg_100;
 }
 
-/* Returns 100 times the current thread's recent_cpu value. */
+/* 현재 스레드 recent_cpu의 100배를 반올림해서 반환 */
 int thread_get_recent_cpu(void) {
-    /* TODO: Your implementation goes here */
-    return 0;
+
+    enum intr_level old_level = intr_disable();
+    int recent_cpu_100 = fp_to_int_round(fp_mul_int(thread_current()->recent_cpu, 100));
+    intr_set_level(old_level);
+
+    return recent_cpu_100;
+}
+
+/* thread_tick()에서 호출되는 MLFQS 갱신 함수 (External Interrupt Context 전용) ; TICKS는 처리 중인 Tick */
+static void mlfqs_tick(struct thread *t, int64_t ticks) {
+
+    uint64_t start = rdtsc();
+
+    /* (1) Run 중인 스레드의 recent_cpu만 증가 (Idle 제외) ; 우선순위 재계산 대상으로 기록 */
+    if (t != idle_thread) {
+        t->recent_cpu = fp_add_int(t->recent_cpu, 1);
+
+        int i;
+        for (i = 0; i < recent_cpu_changed_cnt; i++)
+            if (recent_cpu_changed[i] == t)
+                break;
+        if (i == recent_cpu_changed_cnt) {
+            /* 갱신 주기마다 비워지니 가득 찰 일은 없지만, 넘치지 않도록 먼저 재계산하고 비움 */
+            if (recent_cpu_changed_cnt == PRIORITY_UPDATE_TICKS) {
+                for (i = 0; i < recent_cpu_changed_cnt; i++)
+                    mlfqs_update_priority(recent_cpu_changed[i]);
+                recent_cpu_changed_cnt = 0;
+            }
+            recent_cpu_changed[recent_cpu_changed_cnt++] = t;
+        }
+    }
+
+    if (ticks % TIMER_FREQ == 0) {
+
+        /* (3) load_avg = (59/60) * load_avg + (1/60) * ready_threads */
+        int ready_threads = ready_cnt + (t != idle_thread ? 1 : 0);
+        load_avg = fp_add(fp_mul(fp_div_int(int_to_fp(59), 60), load_avg), fp_div_int(int_to_fp(ready_threads), 60));
+
+        /* 모든 스레드의 recent_cpu와 우선순위를 한번에 재계산 (초당 한번의 O(n) 순회) */
+        struct list_elem *e;
+        for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+            struct thread *th = list_entry(e, struct thread, all_elem);
+            if (th == idle_thread)
+                continue;
+            mlfqs_update_recent_cpu(th);
+            mlfqs_update_priority(th);
+        }
+        recent_cpu_changed_cnt = 0;
+
+    } else if (ticks % PRIORITY_UPDATE_TICKS == 0) {
+
+        /* (2) 입력값 (recent_cpu)이 바뀐 스레드들만 우선순위 재계산 */
+        for (int i = 0; i < recent_cpu_changed_cnt; i++)
+            mlfqs_update_priority(recent_cpu_changed[i]);
+        recent_cpu_changed_cnt = 0;
+    }
+
+    /* 재계산 결과 Run 중인 스레드보다 우선순위가 높은 스레드가 생겼다면 Interrupt 복귀 시점에 양보 */
+    if (ready_queue_preempts(t))
+        intr_yield_on_return();
+
+    /* 오버헤드 통계 갱신 (thread_print_stats에서 출력) */
+    uint64_t cycles = rdtsc() - start;
+    mlfqs_ticks++;
+    mlfqs_cycles += cycles;
+    if (cycles > mlfqs_max_cycles)
+        mlfqs_max_cycles = cycles;
+}
+
+/* priority = PRI_MAX - (recent_cpu / 4) - (nice * 2) 로 우선순위를 다시 계산하는 함수.
+   READY 상태라면 ready_queue 내 위치도 새로운 우선순위에 맞게 옮겨줌. */
+static void mlfqs_update_priority(struct thread *t) {
+
+    int priority = PRI_MAX - fp_to_int(fp_div_int(t->recent_cpu, 4)) - t->nice * 2;
+
+    if (priority > PRI_MAX)
+        priority = PRI_MAX;
+    if (priority < PRI_MIN)
+        priority = PRI_MIN;
+
+    if (priority == t->priority)
+        return;
+
+    if (t->status == THREAD_READY) {
+        ready_queue_remove(t);
+        t->priority = priority;
+        ready_queue_push(t);
+    } else {
+        t->priority = priority;
+    }
+    if (t->waitqueue != NULL)
+        waitqueue_update(t);
+}
+
+/* recent_cpu = (2 * load_avg) / (2 * load_avg + 1) * recent_cpu + nice 로 recent_cpu를 다시 계산하는 함수 */
+static void mlfqs_update_recent_cpu(struct thread *t) {
+
+    fixed_t twice_load = fp_mul_int(load_avg, 2);
+    fixed_t coefficient = fp_div(twice_load, fp_add_int(twice_load, 1));
+
+    t->recent_cpu = fp_add_int(fp_mul(coefficient, t->recent_cpu), t->nice);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -396,8 +921,8 @@ int thread_get_recent_cpu(void) {
 ////////////////////////////////////////////////////////////////////////////////
 
 /* Idle 스레드를 위한 전용 함수 (스레드가 실행하고 있는 코드).
-   이 스레드는 특수 스레드로, 스케쥴러가 CPU를 할당할 스레드가 없을 때 활용 (ready_list가 비어있을 경우).
-   최초 스레드 시스템 초기화 과정에서 ready_list에 넣지만, 그 이후 다시는 ready_list에 넣지 않음.
+   이 스레드는 특수 스레드로, 스케쥴러가 CPU를 할당할 스레드가 없을 때 활용 (ready_queue가 비어있을 경우).
+   최초 스레드 시스템 초기화 과정에서 ready_queue에 넣지만, 그 이후 다시는 ready_queue에 넣지 않음.
    더 이상 구동할 스레드가 없을 때 next_thread_to_run()에서 explicit 하게 지정하는 형태. */
 static void idle(void *idle_started_ UNUSED) {
 
@@ -408,6 +933,12 @@ static void idle(void *idle_started_ UNUSED) {
 
     /* 종료되지 않도록 무제한 반복문 형태로 구성 */
     for (;;) {
+        /* 할 일이 없는 동안 free 페이지를 미리 0으로 채워둠 (PAL_ZERO 할당이 memset 없이 가져가도록).
+           Interrupt를 켠 채로 한 페이지씩 진행하고, 그 사이 Interrupt가 깨운 스레드가 하나라도 있다면 바로 멈추고 양보
+           (idle보다 높은지가 아니라 ready_queue/edf_ready_heap이 비었는지로 판단 ; PRI_MIN 스레드도 기다리지 않도록) */
+        while (ready_cnt == 0 && palloc_prezero())
+            continue;
+
         intr_disable(); // Interrupt를 끄고,
         thread_block(); // Unblock 상태로 무한정 대기
 
@@ -443,7 +974,8 @@ static void init_thread(struct thread *t, const char *name, int priority) {
     t->priority = priority;
     t->priority_original = priority; // 최초 부여된 우선순위를 저장하는 역할 (건드리지 않음)
     t->waiting_for_lock = NULL;      // 스레드가 특정 락을 기다리며 Block 상태로 들어갔을 때 설정
-    list_init(&t->donations);        // 우선순위를 기부받는다면 저장하는 리스트
+    heap_init(&t->held_locks, held_lock_comparison, NULL); // 보유 중인 락들 (Donation 계산용)
+    heap_init(&t->owned_queues, owned_queue_comparison, NULL); // owner로 지정된 semaphore, cond 등 (Donation 계산용)
     t->magic = THREAD_MAGIC;
 
     /* Fork, Exec, Wait 관련 멤버들 활성화 */
@@ -455,15 +987,112 @@ static void init_thread(struct thread *t, const char *name, int priority) {
     t->exit_status = 0;          // 기본 값은 0 (exit 없이 성공적으로 탈출))
     t->already_waited = false; // 해당 자식이 아직 wait를 받은적이 없다는 의미
     t->fork_depth = 0;
+
+    /* MLFQS 관련 멤버 초기화 (thread_create에서 부모 값을 물려받음) */
+    t->nice = NICE_DEFAULT;
+    t->recent_cpu = 0;
+
+    /* 자원 사용량 측정 시작 (rusage는 위의 memset으로 0) */
+    t->state_since = rdtsc();
+
+    /* all_list는 Timer Interrupt에서도 순회하니 Interrupt를 끈 상태에서 삽입 */
+    enum intr_level old_level = intr_disable();
+    list_push_back(&all_list, &t->all_elem);
+    intr_set_level(old_level);
 }
 
 /* CPU를 할당받을 다음 스레드를 고르는 함수 (idle thread가 여기서 적용) */
 static struct thread *next_thread_to_run(void) {
 
-    if (list_empty(&ready_list))
+    if (ready_cnt == 0)
         return idle_thread;
     else
-        return list_entry(list_pop_front(&ready_list), struct thread, elem);
+        return ready_queue_pop();
+}
+
+/* 스레드를 자신의 우선순위에 해당하는 ready_queue 맨 뒤에 넣고 bitmap에 표시하는 함수 (O(1), Interrupt가 꺼진 상태여야 함) */
+static void ready_queue_push(struct thread *t) {
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+    /* 예산이 남은 EDF 스레드는 우선순위 대신 마감 기준으로 edf_ready_heap에 삽입 (O(log n)) */
+    if (edf_active(t)) {
+        heap_push(&edf_ready_heap, &t->edf_elem);
+        t->edf_queued = true;
+        ready_cnt++;
+        return;
+    }
+
+    list_push_back(&ready_queue[t->priority], &t->elem);
+    ready_bitmap |= 1ULL << t->priority;
+    ready_cnt++;
+}
+
+/* READY 상태인 스레드를 ready_queue에서 빼내는 함수 (우선순위 변경 시 위치를 옮기는 용도 ; O(1)) */
+static void ready_queue_remove(struct thread *t) {
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t->status == THREAD_READY);
+
+    if (t->edf_queued) {
+        heap_remove(&edf_ready_heap, &t->edf_elem);
+        t->edf_queued = false;
+        ready_cnt--;
+        return;
+    }
+
+    list_remove(&t->elem);
+    if (list_empty(&ready_queue[t->priority]))
+        ready_bitmap &= ~(1ULL << t->priority);
+    ready_cnt--;
+}
+
+/* 다음에 실행할 스레드를 꺼내는 함수 ; EDF 스레드가 있다면 마감이 가장 이른 스레드를 (O(log n)),
+   아니라면 가장 높은 우선순위 레벨의 맨 앞 스레드를 꺼냄 (O(1) ; bsr로 최상위 비트를 찾음).
+   스레드가 대기 중에 Donation으로 priority가 바뀌었을 수 있으니, 비트 정리는 t->priority가 아닌 꺼낸 레벨 기준으로 수행. */
+static struct thread *ready_queue_pop(void) {
+
+    struct heap_elem *top = heap_pop(&edf_ready_heap);
+
+    if (top != NULL) {
+        struct thread *t = heap_entry(top, struct thread, edf_elem);
+        t->edf_queued = false;
+        ready_cnt--;
+        return t;
+    }
+
+    ASSERT(ready_bitmap != 0);
+
+    int pri = 63 - __builtin_clzll(ready_bitmap);
+    struct thread *t = list_entry(list_pop_front(&ready_queue[pri]), struct thread, elem);
+
+    if (list_empty(&ready_queue[pri]))
+        ready_bitmap &= ~(1ULL << pri);
+    ready_cnt--;
+
+    return t;
+}
+
+/* ready_queue에 대기중인 스레드 중 가장 높은 우선순위를 반환하는 함수 (비어있다면 PRI_MIN - 1) */
+static int ready_queue_max_priority(void) {
+
+    if (ready_bitmap == 0)
+        return PRI_MIN - 1;
+
+    return 63 - __builtin_clzll(ready_bitmap);
+}
+
+/* ready_queue에 CUR보다 먼저 실행되어야 하는 스레드가 있는지 확인하는 함수.
+   EDF 스레드는 우선순위 클래스보다 항상 먼저이며, EDF 스레드끼리는 마감이 이른 쪽이 먼저. */
+static bool ready_queue_preempts(struct thread *cur) {
+
+    struct heap_elem *top = heap_top(&edf_ready_heap);
+
+    if (top != NULL)
+        return !edf_active(cur) || heap_entry(top, struct thread, edf_elem)->edf_deadline < cur->edf_deadline;
+
+    return !edf_active(cur) && ready_queue_max_priority() > cur->priority;
 }
 
 /* Interrupted Thread 복구 함수 (저장했던 값들을 Register 등에 복구 ; ends in iretq) */
@@ -495,11 +1124,43 @@ void do_iret(struct intr_frame *tf) {
                      : "memory");
 }
 
-/* Context Switching을 수행하는 메인 함수 (do_iret()을 활용하는 함수).
+/* Context Switching을 수행하는 메인 함수.
    이 함수가 호출되는 시점은 PREV 스레드에서 스위칭이 완료 된 시점이며, 새로운 스레드가 이미 Running 상태.
-   Interrupt는 여전히 꺼져 있어야 함. */
+   Interrupt는 여전히 꺼져 있어야 함.
+   스레드는 항상 schedule() 안에서 (커널 모드로) CPU를 내주므로, 평소에는 Callee-saved 레지스터만 저장하는
+   switch_fast()를 사용. 유저 모드의 레지스터는 이미 Interrupt/Syscall 진입 시 커널 스택의 intr_frame에 있음. */
 static void thread_launch(struct thread *th) {
 
+    struct thread *curr = running_thread();
+    uint64_t next_rsp = th->switch_rsp;
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (!thread_fast_switch) {
+        /* switch_fast()로 멈춰 있던 스레드라면, 그 상태를 do_iret()이 복원할 수 있는 intr_frame으로 변환 */
+        if (next_rsp != 0) {
+            memset(&th->tf, 0, sizeof th->tf);
+            th->tf.rip = (uintptr_t)switch_resume;
+            th->tf.rsp = next_rsp;
+            th->tf.ds = SEL_KDSEG;
+            th->tf.es = SEL_KDSEG;
+            th->tf.ss = SEL_KDSEG;
+            th->tf.cs = SEL_KCSEG;
+            th->tf.eflags = FLAG_MBS; // Interrupt는 꺼진 채로 재개
+            th->switch_rsp = 0;
+        }
+        thread_launch_frame(th);
+    } else if (next_rsp != 0) {
+        th->switch_rsp = 0;
+        switch_fast(&curr->switch_rsp, next_rsp);
+    } else {
+        /* 새로 만들어진 스레드이거나 intr_frame 경로로 멈춘 스레드 */
+        switch_to_frame(&curr->switch_rsp, &th->tf);
+    }
+}
+
+/* intr_frame 전체를 저장하고 do_iret()으로 다음 스레드로 전환하는 기존 경로 (thread_fast_switch가 false일 때) */
+static void thread_launch_frame(struct thread *th) {
+
     uint64_t tf_cur = (uint64_t)&running_thread()->tf;
     uint64_t tf = (uint64_t)&th->tf;
     ASSERT(intr_get_level() == INTR_OFF);
@@ -564,7 +1225,8 @@ static void do_schedule(int status) {
     /* Exit한 함수들을 실제로 삭제 */
     while (!list_empty(&destruction_req)) {
         struct thread *victim = list_entry(list_pop_front(&destruction_req), struct thread, elem);
-        palloc_free_page(victim);
+        page_cache_put(&fd_table_cache, victim->fd_table);
+        page_cache_put(&thread_page_cache, victim);
     }
 
     /* 파라미터 값으로 받은 Status를 적용한 뒤 Schedule() 호출 */
@@ -583,12 +1245,48 @@ static void schedule(void) {
     ASSERT(curr->status != THREAD_RUNNING);
     ASSERT(is_thread(next));
 
+    /* 현재 스레드가 CPU를 사용한 시간을 누적 ; 이후 READY/BLOCKED 상태의 시간은 여기서부터 측정 */
+    uint64_t now = rdtsc();
+    curr->rusage.cpu_cycles += now - curr->state_since;
+    curr->state_since = now;
+
+    if (curr != next) {
+        /* 전환 사유와 함께 트레이스에 기록 (thread_ticks는 아래에서 초기화되니 그 전에 확인) */
+        uint8_t reason = curr->status == THREAD_BLOCKED ? TRACE_BLOCK
+                         : curr->status == THREAD_DYING ? TRACE_EXIT
+                         : thread_ticks >= TIME_SLICE   ? TRACE_SLICE
+                                                        : TRACE_YIELD;
+        trace_record(TRACE_SWITCH, curr->tid, next->tid, curr->status, reason, next->priority);
+
+        /* Block으로 인한 전환은 자발적, Run 가능한 상태에서 밀려난 전환은 비자발적 */
+        if (curr->status == THREAD_BLOCKED)
+            curr->rusage.voluntary_switches++;
+        else if (curr->status == THREAD_READY)
+            curr->rusage.involuntary_switches++;
+
+        /* 다음 스레드가 READY 상태로 CPU를 기다린 시간을 누적 */
+        next->rusage.ready_cycles += now - next->state_since;
+        next->state_since = now;
+    }
+
+    /* 종료되는 스레드의 자원 사용량은 페이지가 해제되기 전에 복사해서 보관 */
+    if (curr->status == THREAD_DYING) {
+        struct rusage_record *r = &rusage_history[rusage_exited++ % RUSAGE_HISTORY];
+        r->tid = curr->tid;
+        strlcpy(r->name, curr->name, sizeof r->name);
+        r->rusage = curr->rusage;
+    }
+
     /* 선정된 새로운 스레드의 status 값을 변경 */
     next->status = THREAD_RUNNING;
 
     /* 타임슬라이스 값을 초기화 */
     thread_ticks = 0;
 
+    /* Tickless 모드에서 Idle 중에 걸어둔 긴 One-shot이 새 스레드의 Time slice를 넘기지 않도록 조정 */
+    if (curr == idle_thread && next != idle_thread)
+        timer_arm(timer_ticks() + TIME_SLICE);
+
 #ifdef USERPROG
 
     /* 프로세스의 Address Space를 활성화 */
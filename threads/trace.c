@@ -0,0 +1,134 @@
+#include "threads/trace.h"
+#include "devices/serial.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+#include "threads/interrupt.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TRACE_SIZE 2048      // Ring buffer에 보관하는 이벤트의 수 (가장 최근 것들만 남음)
+#define TRACE_NAME_SIZE 256  // 이름을 기억해두는 스레드의 수 (덤프 시 tid → 이름 매핑용)
+#define TRACE_NAME_LEN 16    // struct thread의 name과 동일
+
+/* 트레이스 기록 여부 ; 커널 커맨드라인 옵션 -trace로 켬 */
+bool trace_enabled;
+
+static struct trace_event trace_buf[TRACE_SIZE]; // 이벤트 Ring buffer
+static uint64_t trace_cnt;                       // 지금까지 기록된 이벤트의 수 (다음 기록 위치 = trace_cnt % TRACE_SIZE)
+
+/* 스레드 이름 테이블 (Ring buffer ; 오래된 스레드부터 덮어씀) */
+static struct {
+    int32_t tid;
+    char name[TRACE_NAME_LEN];
+} trace_names[TRACE_NAME_SIZE];
+static unsigned trace_name_cnt;
+
+/* TSC 주파수 추정용 기준점 */
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+static void dump_base64(const uint8_t *, size_t);
+static void dump_string(const char *);
+
+/* 트레이스를 초기화하는 함수 (timer_calibrate 이후 호출 ; TSC 주파수 추정 기준점을 잡음) */
+void trace_init(void) {
+    start_tsc = rdtsc();
+    start_ticks = timer_ticks();
+}
+
+/* 이벤트 하나를 Ring buffer에 기록하는 함수 (Interrupt Handler에서도 호출 가능) */
+void trace_record(enum trace_type type, int32_t tid, int32_t other, uint8_t status, uint8_t reason, uint32_t arg) {
+
+    if (!trace_enabled)
+        return;
+
+    enum intr_level old_level = intr_disable();
+    struct trace_event *e = &trace_buf[trace_cnt++ % TRACE_SIZE];
+
+    e->tsc = rdtsc();
+    e->tid = tid;
+    e->other = other;
+    e->type = type;
+    e->status = status;
+    e->reason = reason;
+    e->intr = intr_context();
+    e->arg = arg;
+    intr_set_level(old_level);
+}
+
+/* 새로 생성된 스레드의 이름을 기록해두는 함수 (thread_create에서 호출) */
+void trace_thread_name(int32_t tid, const char *name) {
+
+    if (!trace_enabled)
+        return;
+
+    enum intr_level old_level = intr_disable();
+    unsigned i = trace_name_cnt++ % TRACE_NAME_SIZE;
+
+    trace_names[i].tid = tid;
+    strlcpy(trace_names[i].name, name, TRACE_NAME_LEN);
+    intr_set_level(old_level);
+}
+
+/* Ring buffer를 Serial 포트로 덤프하는 함수 (console lock을 거치지 않음).
+   형식 :
+     TRACE-BEGIN <이벤트 수> <TSC Hz (추정 ; 모르면 0)>
+     TRACE-THREAD <tid> <이름>          (스레드마다 한 줄)
+     <이벤트 레코드들을 Base64로 인코딩한 줄들>
+     TRACE-END
+   텍스트 출력과 섞여도 깨지지 않도록 바이너리 레코드는 Base64로 감쌈. */
+void trace_dump(void) {
+
+    enum intr_level old_level = intr_disable();
+    uint64_t cnt = trace_cnt < TRACE_SIZE ? trace_cnt : TRACE_SIZE;
+    uint64_t first = trace_cnt - cnt;
+    int64_t elapsed = timer_ticks() - start_ticks;
+    uint64_t hz = elapsed > 0 ? (rdtsc() - start_tsc) / elapsed * TIMER_FREQ : 0;
+    char line[64];
+
+    snprintf(line, sizeof line, "TRACE-BEGIN %llu %llu\n", cnt, hz);
+    dump_string(line);
+
+    unsigned name_cnt = trace_name_cnt < TRACE_NAME_SIZE ? trace_name_cnt : TRACE_NAME_SIZE;
+    for (unsigned i = trace_name_cnt - name_cnt; i < trace_name_cnt; i++) {
+        snprintf(line, sizeof line, "TRACE-THREAD %d %s\n", trace_names[i % TRACE_NAME_SIZE].tid, trace_names[i % TRACE_NAME_SIZE].name);
+        dump_string(line);
+    }
+
+    /* Ring buffer가 한바퀴 돌았다면 가장 오래된 레코드부터 두 조각으로 덤프 */
+    size_t start = first % TRACE_SIZE;
+    size_t head = cnt - (start + cnt > TRACE_SIZE ? start + cnt - TRACE_SIZE : 0);
+    dump_base64((const uint8_t *)&trace_buf[start], head * sizeof *trace_buf);
+    dump_base64((const uint8_t *)trace_buf, (cnt - head) * sizeof *trace_buf);
+
+    dump_string("TRACE-END\n");
+    serial_flush();
+    intr_set_level(old_level);
+}
+
+/* 문자열을 Serial 포트로만 출력하는 함수 */
+static void dump_string(const char *s) {
+    while (*s != '\0')
+        serial_putc(*s++);
+}
+
+/* BUF의 SIZE 바이트를 한 줄에 48바이트 (Base64 64글자)씩 출력하는 함수.
+   레코드 크기 (24바이트)가 3의 배수라서, 줄을 나눠도 Padding 없이 이어 붙여 디코딩할 수 있음. */
+static void dump_base64(const uint8_t *buf, size_t size) {
+
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    ASSERT(size % 3 == 0);
+
+    for (size_t ofs = 0; ofs < size; ofs += 3) {
+        uint32_t v = buf[ofs] << 16 | buf[ofs + 1] << 8 | buf[ofs + 2];
+
+        serial_putc(digits[v >> 18 & 0x3f]);
+        serial_putc(digits[v >> 12 & 0x3f]);
+        serial_putc(digits[v >> 6 & 0x3f]);
+        serial_putc(digits[v & 0x3f]);
+        if ((ofs + 3) % 48 == 0 || ofs + 3 == size)
+            serial_putc('\n');
+    }
+}
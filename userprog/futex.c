@@ -0,0 +1,100 @@
+#include "userprog/futex.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include <hash.h>
+#include <list.h>
+
+/* 유저 프로그램의 futex_wait() / futex_wake() 시스템콜을 위한 대기 큐.
+ * 유저 주소가 아니라 그 주소가 매핑된 물리 주소 (Frame + Offset)를 키로 쓰기 때문에,
+ * 같은 메모리를 서로 다른 주소로 매핑한 경우에도 같은 큐에서 만남.
+ * 큐들은 키의 해시로 고른 Bucket 리스트에 섞여 있으며, 모두 Interrupt를 끈 상태에서 다룸. */
+
+#define FUTEX_BUCKETS 64
+
+/* futex_queue_wait() 중인 스레드 하나 (대기하는 스레드의 커널 스택에 위치) */
+struct futex_waiter {
+    struct list_elem elem; /* futex_table의 Bucket 리스트 elem */
+    struct thread *thread; /* 기다리는 스레드 */
+    uint64_t key;          /* 기다리는 주소의 물리 주소 */
+    bool timed;            /* Timeout이 있어서 sleep_heap에도 들어 있는지 여부 */
+    bool woken;            /* futex_queue_wake()로 깨어났는지 여부 */
+};
+
+static struct list futex_table[FUTEX_BUCKETS];
+
+/* KEY의 대기자들이 들어가는 Bucket */
+static struct list *futex_bucket(uint64_t key) { return &futex_table[hash_bytes(&key, sizeof key) % FUTEX_BUCKETS]; }
+
+/* futex 대기 큐들을 초기화 */
+void futex_init(void) {
+    for (int i = 0; i < FUTEX_BUCKETS; i++)
+        list_init(&futex_table[i]);
+}
+
+/* *KADDR이 EXPECTED라면 futex_queue_wake()로 깨워지거나 TIMEOUT Tick이 지날 때까지 (0 이하라면 무기한) 대기.
+   KADDR은 유저 주소를 pml4_get_page()로 변환한 커널 주소여야 함.
+   값 비교와 대기열 삽입 사이에 Interrupt가 꺼져 있으니, 값을 바꾼 뒤 깨우는 쪽과 엇갈려 Wakeup을 놓치지 않음. */
+int futex_queue_wait(int *kaddr, int expected, int64_t timeout) {
+
+    struct futex_waiter w;
+    enum intr_level old_level = intr_disable();
+
+    if (*(volatile int *)kaddr != expected) {
+        intr_set_level(old_level);
+        return FUTEX_AGAIN;
+    }
+
+    w.thread = thread_current();
+    w.key = vtop(kaddr);
+    w.timed = timeout > 0;
+    w.woken = false;
+    list_push_back(futex_bucket(w.key), &w.elem);
+
+    if (w.timed)
+        thread_sleep(timer_ticks() + timeout); // 먼저 깨워지면 futex_queue_wake()가 sleep_heap에서 빼줌
+    else
+        thread_block();
+
+    /* 시간이 다 되어 깨어났다면 아직 대기열에 남아 있음 */
+    if (!w.woken)
+        list_remove(&w.elem);
+    intr_set_level(old_level);
+
+    return w.woken ? FUTEX_WOKEN : FUTEX_TIMEDOUT;
+}
+
+/* KADDR에서 기다리는 스레드를 최대 N개까지 우선순위가 높은 순서대로 (같다면 먼저 기다린 순서로) 깨우고, 깨운 수를 반환 */
+int futex_queue_wake(int *kaddr, int n) {
+
+    uint64_t key = vtop(kaddr);
+    struct list *bucket = futex_bucket(key);
+    int woken = 0;
+    enum intr_level old_level = intr_disable();
+
+    while (woken < n) {
+        struct futex_waiter *best = NULL;
+        struct list_elem *e;
+
+        /* 시간이 다 되어 이미 깨어난 (BLOCKED가 아닌) 대기자는 스스로 빠져나갈 테니 제외 */
+        for (e = list_begin(bucket); e != list_end(bucket); e = list_next(e)) {
+            struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+            if (w->key == key && w->thread->status == THREAD_BLOCKED && (best == NULL || w->thread->priority > best->thread->priority))
+                best = w;
+        }
+        if (best == NULL)
+            break;
+
+        list_remove(&best->elem);
+        best->woken = true;
+        if (best->timed)
+            thread_sleep_cancel(best->thread);
+        thread_unblock(best->thread);
+        woken++;
+    }
+
+    thread_check_yield();
+    intr_set_level(old_level);
+    return woken;
+}
@@ -33,6 +33,7 @@ static void process_cleanup(void);
 static bool load(const char *file_name, struct intr_frame *if_);
 static void initd(void *f_name);
 static void __do_fork(void *);
+static struct thread *find_child(tid_t);
 
 ////////////////////////////////////////////////////////////////////////////////
 //////////////////////////// Process Initiation ////////////////////////////////
@@ -106,8 +107,11 @@ tid_t process_fork(const char *name, struct intr_frame *if_) {
         return TID_ERROR;
     }
 
-    /* Caller의 fork_sema를 내리면서 대기 상태 진입 ; _do_fork가 끝날때 Callee가 sema_up 예정 */
+    /* Caller의 fork_sema를 내리면서 대기 상태 진입 ; _do_fork가 끝날때 Callee가 sema_up 예정.
+       기다리는 동안 자식에게 우선순위를 기부하도록 자식을 fork_sema의 owner로 지정 (자식은 process_exit 전까지 children 리스트에 남아있음) */
+    sema_set_owner(&thread_current()->fork_sema, find_child(pid));
     sema_down(&thread_current()->fork_sema);
+    sema_set_owner(&thread_current()->fork_sema, NULL);
 
     return pid;
 }
@@ -267,18 +271,8 @@ int process_exec(void *f_name) {
    TID가 재대로 된 값이 아니거나, caller의 child가 아니거나, process_wait()이 이미 호출 되었어도 -1 반환. */
 int process_wait(tid_t child_tid) {
 
-    struct thread *curr = thread_current();
-    struct thread *child = NULL;
-
     /* (1) Parent의 children_list를 탐색해서 제공된 tid 매칭 작업 수행 */
-    struct list_elem *e;
-    for (e = list_begin(&curr->children_list); e != list_end(&curr->children_list); e = list_next(e)) {
-        struct thread *t = list_entry(e, struct thread, child_elem);
-        if (t->tid == child_tid) {
-            child = t; // 발견
-            break;
-        }
-    }
+    struct thread *child = find_child(child_tid);
 
     /* (2) 매치가 없다면, 또는 있는데 이미 누군가 wait를 걸었다면, 예외처리. */
     if (!child || child->already_waited) {
@@ -304,11 +298,24 @@ int process_wait(tid_t child_tid) {
     return return_status;
 }
 
+/* 현재 스레드의 children_list에서 TID인 자식을 찾는 함수 (없다면 NULL) */
+static struct thread *find_child(tid_t tid) {
+
+    struct thread *curr = thread_current();
+    struct list_elem *e;
+
+    for (e = list_begin(&curr->children_list); e != list_end(&curr->children_list); e = list_next(e)) {
+        struct thread *t = list_entry(e, struct thread, child_elem);
+        if (t->tid == tid)
+            return t; // 발견
+    }
+    return NULL;
+}
+
 /* thread_exit에서 호출되는 함수로, 프로세스를 종료시킴. */
 void process_exit(void) {
 
     struct thread *curr = thread_current();
-    struct file **table = curr->fd_table;
 
     /* Debug */
     if (!curr->parent_is) {
@@ -332,8 +339,7 @@ void process_exit(void) {
         sema_down(&curr->free_sema);
     }
 
-    /* 페이지 테이블 메모리 반환 및 pml4 리셋 */
-    palloc_free_page(table);
+    /* 페이지 테이블 메모리 반환 및 pml4 리셋 (fd_table 페이지는 스레드 페이지와 함께 do_schedule에서 재활용) */
     process_cleanup();
 }
 
@@ -8,6 +8,8 @@
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/mmu.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "userprog/process.h" // 관련 파일 헤더들 전부 연결
 #include <stdio.h>
@@ -36,6 +38,9 @@ int write(int fd, const void *buffer, unsigned size);
 void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
+int getrusage(struct rusage *usage);
+int futex_wait(int *addr, int expected, int64_t timeout);
+int futex_wake(int *addr, int n);
 
 /* File Descriptor 관련 함수 Prototype & Global Variables */
 int allocate_fd(struct file *file);
@@ -44,8 +49,6 @@ void release_fd(int fd);
 void close_file(int fd);
 // fd_table_destroy는 syscall.h로 이동
 
-struct semaphore filesys_sema; // 파일시스템 동기화를 위한 세마포어
-
 ////////////////////////////////////////////////////////////////////////////////
 //////////////////////////// System Call Handlers //////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -66,7 +69,7 @@ struct semaphore filesys_sema; // 파일시스템 동기화를 위한 세마포
 void syscall_init(void) {
     write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48 | ((uint64_t)SEL_KCSEG) << 32);
     write_msr(MSR_LSTAR, (uint64_t)syscall_entry);
-    sema_init(&filesys_sema, 1);
+    futex_init();
     /* The interrupt service rountine should not serve any interrupts
      * until the syscall_entry swaps the userland stack to the kernel
      * mode stack. Therefore, we masked the FLAG_FL. */
@@ -144,6 +147,18 @@ void syscall_handler(struct intr_frame *f) {
         close(f->R.rdi);
         break;
 
+    case SYS_GETRUSAGE:
+        f->R.rax = getrusage((struct rusage *)f->R.rdi);
+        break;
+
+    case SYS_FUTEX_WAIT:
+        f->R.rax = futex_wait((int *)f->R.rdi, f->R.rsi, f->R.rdx);
+        break;
+
+    case SYS_FUTEX_WAKE:
+        f->R.rax = futex_wake((int *)f->R.rdi, f->R.rsi);
+        break;
+
     default:
         printf("Unknown system call: %d\n", syscall_num); // deprecated by placeholder, but kept in place
         thread_exit();
@@ -442,8 +457,6 @@ int write(int fd, const void *buffer, unsigned size) {
 
     int bytes_written = file_write(file_to_write, buffer, size);
 
-    // sema_up(&filesys_sema);
-
     return bytes_written;
 }
 
@@ -484,6 +497,34 @@ void close(int fd) {
     }
 }
 
+/* 현재 스레드의 자원 사용량 (CPU/READY/BLOCKED 시간, Context switch 횟수)을 usage에 복사하는 시스템콜.
+   성공시 0을 반환하며, usage가 유효하지 않은 주소라면 exit(-1)로 종료됨. */
+int getrusage(struct rusage *usage) {
+
+    if (!buffer_validity_check(usage, sizeof *usage))
+        exit(-1);
+
+    thread_get_rusage(usage);
+    return 0;
+}
+
+/* futex 시스템콜이 받은 유저 주소를 커널 주소로 변환 (4바이트 정렬된 유효한 유저 주소가 아니라면 exit(-1)).
+   Word가 페이지 경계에 걸치지 않으니 한 페이지만 확인하면 됨. */
+static int *futex_kaddr(int *addr) {
+
+    if ((uintptr_t)addr % sizeof *addr != 0 || !pointer_validity_check(addr))
+        exit(-1);
+
+    return pml4_get_page(thread_current()->pml4, addr);
+}
+
+/* *addr이 expected와 같다면 futex_wake()로 깨워지거나 timeout Tick이 지날 때까지 (0 이하라면 무기한) 기다리는 시스템콜.
+   FUTEX_WOKEN, FUTEX_AGAIN (값이 달라서 바로 반환), FUTEX_TIMEDOUT 중 하나를 반환. */
+int futex_wait(int *addr, int expected, int64_t timeout) { return futex_queue_wait(futex_kaddr(addr), expected, timeout); }
+
+/* addr에서 기다리는 스레드를 우선순위가 높은 순서로 최대 n개 깨우고, 깨운 수를 반환하는 시스템콜 */
+int futex_wake(int *addr, int n) { return futex_queue_wake(futex_kaddr(addr), n); }
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////// File Descriptor 전용 함수들 ////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////